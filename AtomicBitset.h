@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	// A view of the blocks of a bitset through which multiple threads can change bits at the same time,
+	// e.g. to use it as a shared occupancy map. Every operation is a single atomic operation on the 64 bit
+	// word holding the bit (or bits), done through std::atomic_ref, and takes a memory order like the
+	// operations of std::atomic do.
+	//
+	// The bitset must not be resized or otherwise changed other than through atomic views while they are in
+	// use. The bits are in the same order as in the bitset, and the bits past its end stay zero.
+	class atomic_bitset_view
+	{
+	public:
+		using word = std::uint64_t;
+
+		static constexpr size_t npos = detail::sNotFound;
+
+		atomic_bitset_view(word* words, size_t numOfBits) :
+			mWords(words),
+			mNumOfBits(numOfBits)
+		{
+			assert(reinterpret_cast<std::uintptr_t>(words) % std::atomic_ref<word>::required_alignment == 0);
+		}
+
+		template<typename Container>
+		atomic_bitset_view(basic_dynamic_bitset<word, Container>& bitset) :
+			atomic_bitset_view(bitset.data(), bitset.size())
+		{}
+
+		bit test(size_t bitIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return (load_word(getWordIndex(bitIndex), order) & getMask(bitIndex)) != 0;
+		}
+
+		// Sets the bit and returns whether it was set before, so only one of the threads setting it sees false.
+		bit test_and_set(size_t bitIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return (fetch_or_word(getWordIndex(bitIndex), getMask(bitIndex), order) & getMask(bitIndex)) != 0;
+		}
+
+		// Resets the bit and returns whether it was set before.
+		bit test_and_reset(size_t bitIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return (fetch_and_word(getWordIndex(bitIndex), ~getMask(bitIndex), order) & getMask(bitIndex)) != 0;
+		}
+
+		word load_word(size_t wordIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return getAtomicWord(wordIndex).load(order);
+		}
+
+		// ORs the mask into the word and returns the previous word. The first bit of the word is its most
+		// significant bit, and the bits past the end of the bitset must not be set.
+		word fetch_or_word(size_t wordIndex, word mask, std::memory_order order = std::memory_order_seq_cst) const
+		{
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert((mask & ~getValidMask(wordIndex)) == 0);
+#endif // _ITERATOR_DEBUG_LEVEL > 0
+			return getAtomicWord(wordIndex).fetch_or(mask, order);
+		}
+
+		// ANDs the mask into the word and returns the previous word.
+		word fetch_and_word(size_t wordIndex, word mask, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return getAtomicWord(wordIndex).fetch_and(mask, order);
+		}
+
+		// Sets the bits from firstBitIndex up to lastBitIndex, with one atomic operation per word. The range
+		// as a whole isn't set atomically, other threads may see some of its words set before others.
+		void set_range(size_t firstBitIndex, size_t lastBitIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			forEachWordInRange(firstBitIndex, lastBitIndex, [this, order](size_t wordIndex, word mask) { fetch_or_word(wordIndex, mask, order); });
+		}
+
+		// Resets the bits from firstBitIndex up to lastBitIndex, like set_range.
+		void reset_range(size_t firstBitIndex, size_t lastBitIndex, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			forEachWordInRange(firstBitIndex, lastBitIndex, [this, order](size_t wordIndex, word mask) { fetch_and_word(wordIndex, ~mask, order); });
+		}
+
+		// Sets the first unset bit at or after startBitIndex and returns its index, or npos if all of those
+		// are set. When threads race for the same bit only one of them gets it, and the others move on to
+		// the next unset bit, so this can hand out slots without a lock.
+		size_t set_first_zero(size_t startBitIndex = 0, std::memory_order order = std::memory_order_seq_cst) const
+		{
+			if (startBitIndex >= mNumOfBits)
+			{
+				return npos;
+			}
+
+			const size_t numOfWords = detail::getNumOfBlocksNeeded<word>(mNumOfBits);
+			word skippedMask = ~word{} >> (startBitIndex % detail::sNumOfBitsInWord);
+
+			for (size_t wordIndex = getWordIndex(startBitIndex); wordIndex < numOfWords; wordIndex++)
+			{
+				const word validMask = getValidMask(wordIndex) & skippedMask;
+				skippedMask = ~word{};
+
+				word value = load_word(wordIndex, std::memory_order_relaxed);
+				while ((~value & validMask) != 0)
+				{
+					const word mask = word{ 1 } << (detail::sNumOfBitsInWord - 1 - std::countl_zero(~value & validMask));
+					value = fetch_or_word(wordIndex, mask, order);
+					if ((value & mask) == 0)
+					{
+						return wordIndex * detail::sNumOfBitsInWord + std::countl_zero(mask);
+					}
+				}
+			}
+			return npos;
+		}
+
+		// Returns the number of set bits. While other threads change bits, the words are counted one at a
+		// time, so the result may not match any single moment.
+		size_t count(std::memory_order order = std::memory_order_seq_cst) const
+		{
+			size_t numOfSetBits{};
+			for (size_t i = 0; i < detail::getNumOfBlocksNeeded<word>(mNumOfBits); i++)
+			{
+				numOfSetBits += std::popcount(load_word(i, order));
+			}
+			return numOfSetBits;
+		}
+
+		size_t size() const
+		{
+			return mNumOfBits;
+		}
+
+		size_t num_words() const
+		{
+			return detail::getNumOfBlocksNeeded<word>(mNumOfBits);
+		}
+
+	private:
+		static size_t getWordIndex(size_t bitIndex)
+		{
+			return bitIndex / detail::sNumOfBitsInWord;
+		}
+
+		static word getMask(size_t bitIndex)
+		{
+			return word{ 1 } << (detail::sNumOfBitsInWord - 1 - bitIndex % detail::sNumOfBitsInWord);
+		}
+
+		// Returns the mask of the bits of the word that are within the bitset.
+		word getValidMask(size_t wordIndex) const
+		{
+			const size_t numOfBits = std::min(mNumOfBits - wordIndex * detail::sNumOfBitsInWord, detail::sNumOfBitsInWord);
+			return ~detail::getLowMask(detail::sNumOfBitsInWord - numOfBits);
+		}
+
+		std::atomic_ref<word> getAtomicWord(size_t wordIndex) const
+		{
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(wordIndex < num_words());
+#endif // _ITERATOR_DEBUG_LEVEL
+			return std::atomic_ref<word>(mWords[wordIndex]);
+		}
+
+		template<typename Function>
+		void forEachWordInRange(size_t firstBitIndex, size_t lastBitIndex, Function&& function) const
+		{
+			assert(firstBitIndex <= lastBitIndex && lastBitIndex <= mNumOfBits);
+
+			while (firstBitIndex < lastBitIndex)
+			{
+				const size_t bitIndexInWord = firstBitIndex % detail::sNumOfBitsInWord;
+				const size_t numOfBits = std::min(lastBitIndex - firstBitIndex, detail::sNumOfBitsInWord - bitIndexInWord);
+				const word mask = detail::getLowMask(numOfBits) << (detail::sNumOfBitsInWord - bitIndexInWord - numOfBits);
+				function(getWordIndex(firstBitIndex), mask);
+				firstBitIndex += numOfBits;
+			}
+		}
+
+		word* mWords;
+		size_t mNumOfBits;
+	};
+}
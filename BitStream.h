@@ -0,0 +1,512 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	namespace detail
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		// Writes all the bytes, continuing after partial writes and interrupts. Throws a std::system_error
+		// if writing fails.
+		inline void writeAll(int fileDescriptor, const void* source, size_t numOfBytes)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(source);
+			while (numOfBytes > 0)
+			{
+				const ssize_t numOfBytesWritten = ::write(fileDescriptor, bytes, numOfBytes);
+				if (numOfBytesWritten == -1)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					throw std::system_error(errno, std::generic_category(), "write");
+				}
+				bytes += numOfBytesWritten;
+				numOfBytes -= static_cast<size_t>(numOfBytesWritten);
+			}
+		}
+
+		// Reads up to numOfBytes bytes, retrying after interrupts, and returns how many were read, which is
+		// only 0 at the end of the file. Throws a std::system_error if reading fails.
+		inline size_t readSome(int fileDescriptor, void* destination, size_t numOfBytes)
+		{
+			while (true)
+			{
+				const ssize_t numOfBytesRead = ::read(fileDescriptor, destination, numOfBytes);
+				if (numOfBytesRead != -1)
+				{
+					return static_cast<size_t>(numOfBytesRead);
+				}
+				if (errno != EINTR)
+				{
+					throw std::system_error(errno, std::generic_category(), "read");
+				}
+			}
+		}
+#endif // __unix__ || __APPLE__
+	}
+
+	// A sink for a bit_writer that writes the bytes to a stream. Failures are reported through the state
+	// of the stream.
+	class stream_sink
+	{
+	public:
+		explicit stream_sink(std::ostream& stream) :
+			mStream(&stream)
+		{}
+
+		void operator()(std::span<const std::byte> bytes) const
+		{
+			mStream->write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		}
+
+	private:
+		std::ostream* mStream;
+	};
+
+#if defined(__unix__) || defined(__APPLE__)
+	// A sink for a bit_writer that writes the bytes to a file descriptor, which it doesn't close. Throws a
+	// std::system_error if writing fails.
+	class file_descriptor_sink
+	{
+	public:
+		explicit file_descriptor_sink(int fileDescriptor) :
+			mFileDescriptor(fileDescriptor)
+		{}
+
+		void operator()(std::span<const std::byte> bytes) const
+		{
+			detail::writeAll(mFileDescriptor, bytes.data(), bytes.size());
+		}
+
+	private:
+		int mFileDescriptor;
+	};
+#endif // __unix__ || __APPLE__
+
+	// Appends bits like a dynamic_bitset, but hands every chunk of completed bytes to a sink instead of
+	// keeping them, so encoding an unbounded stream takes a constant amount of memory. The sink is called
+	// with a std::span<const std::byte>, which is only valid during the call. The bytes are the same as
+	// extracting them from a dynamic_bitset with the same bits pushed back.
+	//
+	// Only the bytes that haven't reached the sink yet are kept, at most about one chunk. Call finish()
+	// to pass on the rest, including an incomplete last byte padded with zeros; destroying a bit_writer
+	// discards whatever is left, as the sink may throw.
+	template<typename Sink>
+	class bit_writer
+	{
+	public:
+		static constexpr size_t sDefaultChunkSize = 1 << 16;
+
+		explicit bit_writer(Sink sink, size_t chunkSizeInBytes = sDefaultChunkSize) :
+			mSink(std::move(sink)),
+			mChunkSizeInBits(chunkSizeInBytes * sNumOfBitsInByte)
+		{
+			assert(chunkSizeInBytes > 0);
+
+			// The buffer holds less than a chunk before every push_back, and no push_back adds more than a chunk
+			// (or 64 bits) at once, so it never needs more than this and never reallocates.
+			mBuffer.reserve(mChunkSizeInBits + std::max(mChunkSizeInBits, detail::sNumOfBitsInWord));
+		}
+
+		template<typename TriviablyCopyableType>
+		void push_back(const TriviablyCopyableType& value)
+		{
+			static_assert(std::is_trivially_copyable<TriviablyCopyableType>::value);
+			push_back(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		void push_back(const char* source, size_t amountOfBytesToPushBack)
+		{
+			// Large, byte aligned writes go straight to the sink rather than through the buffer.
+			if (amountOfBytesToPushBack * sNumOfBitsInByte >= mChunkSizeInBits && mBuffer.size() % sNumOfBitsInByte == 0)
+			{
+				flush();
+				mSink(std::span<const std::byte>(reinterpret_cast<const std::byte*>(source), amountOfBytesToPushBack));
+				mNumOfFlushedBytes += amountOfBytesToPushBack;
+				return;
+			}
+
+			// Anything else is buffered a chunk at a time, so that the buffer stays within its reserved size.
+			const size_t chunkSizeInBytes = mChunkSizeInBits / sNumOfBitsInByte;
+			while (amountOfBytesToPushBack > 0)
+			{
+				const size_t numOfBytes = std::min(amountOfBytesToPushBack, chunkSizeInBytes);
+				mBuffer.push_back(source, numOfBytes);
+				flushIfChunkIsComplete();
+				source += numOfBytes;
+				amountOfBytesToPushBack -= numOfBytes;
+			}
+		}
+
+		void push_back(byte byte)
+		{
+			mBuffer.push_back(byte);
+			flushIfChunkIsComplete();
+		}
+
+		void push_back(bit bit)
+		{
+			mBuffer.push_back(bit);
+			flushIfChunkIsComplete();
+		}
+
+		// Appends the numOfBits (0 to 64) least significant bits of the value, like dynamic_bitset::write_bits.
+		void write_bits(std::uint64_t value, unsigned numOfBits)
+		{
+			mBuffer.write_bits(value, numOfBits);
+			flushIfChunkIsComplete();
+		}
+
+		// Passes every complete byte to the sink, keeping only an incomplete last byte.
+		void flush()
+		{
+			const size_t numOfCompleteBytes = mBuffer.size() / sNumOfBitsInByte;
+			if (numOfCompleteBytes == 0)
+			{
+				return;
+			}
+
+			mSink(std::span<const std::byte>(reinterpret_cast<const std::byte*>(mBuffer.data()), numOfCompleteBytes));
+			mNumOfFlushedBytes += numOfCompleteBytes;
+
+			// Clearing keeps the capacity, so the buffer is reused for the next chunk.
+			const unsigned numOfRemainingBits = static_cast<unsigned>(mBuffer.size() % sNumOfBitsInByte);
+			const unsigned char remainingBits = numOfRemainingBits > 0 ? mBuffer.data()[numOfCompleteBytes] : 0;
+			mBuffer.clear();
+			mBuffer.write_bits(remainingBits >> (sNumOfBitsInByte - numOfRemainingBits), numOfRemainingBits);
+		}
+
+		// Passes all bits to the sink, padding an incomplete last byte with zeros, and returns the number of
+		// bits written in total. Pushing back afterwards continues at the next whole byte.
+		size_t finish()
+		{
+			const size_t numOfBits = size();
+			if (mBuffer.size() % sNumOfBitsInByte != 0)
+			{
+				mBuffer.resize(mBuffer.size_in_bytes() * sNumOfBitsInByte);
+			}
+			flush();
+			return numOfBits;
+		}
+
+		// Returns the number of bits pushed back, including the ones that were passed to the sink.
+		size_t size() const
+		{
+			return mNumOfFlushedBytes * sNumOfBitsInByte + mBuffer.size();
+		}
+
+		const Sink& sink() const
+		{
+			return mSink;
+		}
+
+	private:
+		void flushIfChunkIsComplete()
+		{
+			if (mBuffer.size() >= mChunkSizeInBits)
+			{
+				flush();
+			}
+		}
+
+		Sink mSink;
+		// Byte blocks, so the buffered bits are already in the order the sink expects.
+		basic_dynamic_bitset<unsigned char> mBuffer{};
+		size_t mChunkSizeInBits;
+		size_t mNumOfFlushedBytes{};
+	};
+
+	// A source for a bit_reader that reads the bytes from a stream.
+	class stream_source
+	{
+	public:
+		explicit stream_source(std::istream& stream) :
+			mStream(&stream)
+		{}
+
+		size_t operator()(std::span<std::byte> bytes) const
+		{
+			mStream->read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			return static_cast<size_t>(mStream->gcount());
+		}
+
+	private:
+		std::istream* mStream;
+	};
+
+#if defined(__unix__) || defined(__APPLE__)
+	// A source for a bit_reader that reads the bytes from a file descriptor, which it doesn't close. Throws
+	// a std::system_error if reading fails.
+	class file_descriptor_source
+	{
+	public:
+		explicit file_descriptor_source(int fileDescriptor) :
+			mFileDescriptor(fileDescriptor)
+		{}
+
+		size_t operator()(std::span<std::byte> bytes) const
+		{
+			return detail::readSome(mFileDescriptor, bytes.data(), bytes.size());
+		}
+
+	private:
+		int mFileDescriptor;
+	};
+#endif // __unix__ || __APPLE__
+
+	// Reads bits from a source incrementally, with the same order as a dynamic_bitset they were pushed back
+	// into: the first bit is the most significant bit of the first byte, like byte::get(0). Only a buffer
+	// of a fixed size is kept in memory, so inputs of any size can be decoded without reading them whole.
+	//
+	// The source is called with a std::span<std::byte> to fill, and returns the number of bytes it filled,
+	// which must only be 0 at the end of the input. Reading past the end throws a std::out_of_range, after
+	// which the position is unspecified; at_end() tells whether any bits are left.
+	template<typename Source>
+	class bit_reader
+	{
+	public:
+		static constexpr size_t sDefaultBufferSize = 1 << 16;
+
+		explicit bit_reader(Source source, size_t bufferSizeInBytes = sDefaultBufferSize) :
+			mSource(std::move(source)),
+			mBuffer(bufferSizeInBytes)
+		{
+			assert(bufferSizeInBytes >= sizeof(detail::word));
+		}
+
+		bit read_bit()
+		{
+			if (mNumOfCachedBits == 0)
+			{
+				refillCache();
+				if (mNumOfCachedBits == 0)
+				{
+					throw std::out_of_range("Read past the end of the bits");
+				}
+			}
+			return static_cast<bit>(takeCachedBits(1));
+		}
+
+		// Returns the next numOfBits (0 to 64) bits in the least significant bits of the return value, the
+		// first of them being the most significant, like dynamic_bitset::read_bits.
+		std::uint64_t read_bits(unsigned numOfBits)
+		{
+			assert(numOfBits <= detail::sNumOfBitsInWord);
+
+			if (numOfBits <= mNumOfCachedBits)
+			{
+				return takeCachedBits(numOfBits);
+			}
+
+			refillCache();
+			if (numOfBits <= mNumOfCachedBits)
+			{
+				return takeCachedBits(numOfBits);
+			}
+			if (mNumOfCachedBits == 0)
+			{
+				throw std::out_of_range("Read past the end of the bits");
+			}
+
+			// The cache is refilled a byte at a time, so it may hold fewer bits than a whole word.
+			const unsigned numOfHighBits = mNumOfCachedBits;
+			const std::uint64_t highBits = takeCachedBits(numOfHighBits);
+			refillCache();
+			const unsigned numOfLowBits = numOfBits - numOfHighBits;
+			if (numOfLowBits > mNumOfCachedBits)
+			{
+				throw std::out_of_range("Read past the end of the bits");
+			}
+			return (highBits << numOfLowBits) | takeCachedBits(numOfLowBits);
+		}
+
+		// Creates and returns an instance of the type from the next sizeof(type) bytes, like dynamic_bitset::extract.
+		template<typename TriviablyCopyableType>
+		TriviablyCopyableType extract()
+		{
+			static_assert(std::is_trivially_copyable<TriviablyCopyableType>::value);
+
+			TriviablyCopyableType returnValue{};
+			extract(reinterpret_cast<char*>(&returnValue), sizeof(returnValue));
+			return returnValue;
+		}
+
+		// Fills the destination with the next bytes. When the reader is at a whole byte, these are copied
+		// from the buffer, and large reads go straight from the source into the destination.
+		void extract(char* destination, size_t amountOfBytesToExtract)
+		{
+			if (mNumOfCachedBits % sNumOfBitsInByte != 0)
+			{
+				for (; amountOfBytesToExtract >= sizeof(detail::word); amountOfBytesToExtract -= sizeof(detail::word), destination += sizeof(detail::word))
+				{
+					detail::storeBigEndian(reinterpret_cast<unsigned char*>(destination), read_bits(detail::sNumOfBitsInWord));
+				}
+				detail::storeBigEndian(reinterpret_cast<unsigned char*>(destination), read_bits(static_cast<unsigned>(amountOfBytesToExtract * sNumOfBitsInByte)), amountOfBytesToExtract);
+				return;
+			}
+
+			for (; amountOfBytesToExtract > 0 && mNumOfCachedBits > 0; amountOfBytesToExtract--, destination++)
+			{
+				*destination = static_cast<char>(takeCachedBits(sNumOfBitsInByte));
+			}
+
+			while (amountOfBytesToExtract > 0)
+			{
+				if (mBufferPosition == mBufferEnd)
+				{
+					if (amountOfBytesToExtract >= mBuffer.size())
+					{
+						const size_t numOfBytesRead = readFromSource(destination, amountOfBytesToExtract);
+						if (numOfBytesRead == 0)
+						{
+							throw std::out_of_range("Read past the end of the bits");
+						}
+						mNumOfBytesConsumed += numOfBytesRead;
+						destination += numOfBytesRead;
+						amountOfBytesToExtract -= numOfBytesRead;
+						continue;
+					}
+					refillBuffer();
+					if (mBufferPosition == mBufferEnd)
+					{
+						throw std::out_of_range("Read past the end of the bits");
+					}
+				}
+
+				const size_t numOfBytes = std::min(amountOfBytesToExtract, mBufferEnd - mBufferPosition);
+				std::memcpy(destination, mBuffer.data() + mBufferPosition, numOfBytes);
+				mBufferPosition += numOfBytes;
+				mNumOfBytesConsumed += numOfBytes;
+				destination += numOfBytes;
+				amountOfBytesToExtract -= numOfBytes;
+			}
+		}
+
+		// Returns whether all bits have been read, which may need to read from the source.
+		bool at_end()
+		{
+			if (mNumOfCachedBits == 0)
+			{
+				refillCache();
+			}
+			return mNumOfCachedBits == 0;
+		}
+
+		// Returns the number of bits read so far.
+		size_t position() const
+		{
+			return mNumOfBytesConsumed * sNumOfBitsInByte - mNumOfCachedBits;
+		}
+
+		const Source& source() const
+		{
+			return mSource;
+		}
+
+	private:
+		// Returns the next numOfBits cached bits, of which there must be enough.
+		std::uint64_t takeCachedBits(unsigned numOfBits)
+		{
+			if (numOfBits == 0)
+			{
+				return 0;
+			}
+
+			const std::uint64_t value = mCache >> (detail::sNumOfBitsInWord - numOfBits);
+			mCache = numOfBits == detail::sNumOfBitsInWord ? 0 : mCache << numOfBits;
+			mNumOfCachedBits -= numOfBits;
+			return value;
+		}
+
+		// Moves as many whole bytes from the buffer into the cache as fit, reading from the source if needed.
+		void refillCache()
+		{
+			if (mBufferEnd - mBufferPosition < sizeof(detail::word))
+			{
+				refillBuffer();
+			}
+
+			const unsigned numOfBytes = static_cast<unsigned>(std::min((detail::sNumOfBitsInWord - mNumOfCachedBits) / sNumOfBitsInByte, mBufferEnd - mBufferPosition));
+			const unsigned char* const bytes = mBuffer.data() + mBufferPosition;
+
+			if (numOfBytes == sizeof(detail::word))
+			{
+				mCache = detail::loadBigEndian(bytes);
+			}
+			else if (numOfBytes > 0)
+			{
+				// The cached bits are at the top, so the new bytes go right below them.
+				const unsigned numOfNewBits = numOfBytes * sNumOfBitsInByte;
+				mCache |= detail::loadBigEndian(bytes, numOfBytes) << (detail::sNumOfBitsInWord - mNumOfCachedBits - numOfNewBits);
+			}
+
+			mBufferPosition += numOfBytes;
+			mNumOfBytesConsumed += numOfBytes;
+			mNumOfCachedBits += numOfBytes * sNumOfBitsInByte;
+		}
+
+		// Moves the unread bytes to the front of the buffer and fills the rest from the source, until it
+		// holds at least a word or the input ends.
+		void refillBuffer()
+		{
+			const size_t numOfUnreadBytes = mBufferEnd - mBufferPosition;
+			std::memmove(mBuffer.data(), mBuffer.data() + mBufferPosition, numOfUnreadBytes);
+			mBufferPosition = 0;
+			mBufferEnd = numOfUnreadBytes;
+
+			while (mBufferEnd < sizeof(detail::word))
+			{
+				const size_t numOfBytesRead = readFromSource(reinterpret_cast<char*>(mBuffer.data()) + mBufferEnd, mBuffer.size() - mBufferEnd);
+				if (numOfBytesRead == 0)
+				{
+					break;
+				}
+				mBufferEnd += numOfBytesRead;
+			}
+		}
+
+		size_t readFromSource(char* destination, size_t numOfBytes)
+		{
+			// Sources may block until there is more input, so they aren't asked again once they have ended.
+			if (mIsSourceExhausted)
+			{
+				return 0;
+			}
+
+			const size_t numOfBytesRead = mSource(std::span<std::byte>(reinterpret_cast<std::byte*>(destination), numOfBytes));
+			mIsSourceExhausted = numOfBytesRead == 0;
+			return numOfBytesRead;
+		}
+
+		Source mSource;
+		std::vector<unsigned char> mBuffer;
+		size_t mBufferPosition{};
+		size_t mBufferEnd{};
+		// The next bits, starting at the most significant bit. The bits past the cached ones are zero.
+		std::uint64_t mCache{};
+		unsigned mNumOfCachedBits{};
+		size_t mNumOfBytesConsumed{};
+		bool mIsSourceExhausted{};
+	};
+}
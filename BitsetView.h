@@ -0,0 +1,482 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	// A read-only view of bits stored elsewhere, e.g. in a memory mapped file or in a basic_dynamic_bitset,
+	// with the same const interface as basic_dynamic_bitset. Nothing is copied, the blocks need to outlive
+	// the view.
+	//
+	// The bits are encoded the same way as in basic_dynamic_bitset: the first bit is the most significant
+	// bit of the first block. With the default unsigned char blocks, that means the bytes are in the same
+	// order as they were pushed back / are extracted, so any file of bytes can be viewed. Unlike in a
+	// basic_dynamic_bitset, the bits past the last bit don't need to be zero.
+	//
+	// A view of a basic_dynamic_bitset has the same Block as the bitset, so bitset_view (unsigned char blocks)
+	// can't view a dynamic_bitset (64 bit blocks). Class template argument deduction picks the Block, e.g.
+	// basic_bitset_view view(bitset).
+	template<typename Block = unsigned char>
+	class basic_bitset_view
+	{
+		static_assert(std::is_unsigned<Block>::value && !std::is_same<Block, bool>::value, "Blocks must be unsigned integers");
+
+		static constexpr size_t sNumOfBitsInBlock = sNumOfBitsInType<Block>;
+
+	public:
+		using block_type = Block;
+
+		class const_iterator :
+			public detail::IteratorBase<const_iterator>
+		{
+		public:
+			constexpr const_iterator() = default;
+			constexpr const_iterator(const basic_bitset_view* source, byte_index byteIndex, bit_index bitIndex) : detail::IteratorBase<const_iterator>(byteIndex, bitIndex), mSource(source) {}
+
+			using pointer = bit;
+			using reference = bit;
+
+			constexpr reference operator*() const
+			{
+#if _ITERATOR_DEBUG_LEVEL > 0
+				assert(mSource != nullptr);
+#endif // _ITERATOR_DEBUG_LEVEL > 0
+				return mSource->get(this->mByteIndex, this->mBitIndex);
+			}
+			constexpr pointer operator->() const
+			{
+				return *(*this);
+			}
+
+			constexpr operator bit() const
+			{
+				return *(*this);
+			}
+
+		private:
+			friend basic_bitset_view;
+			const basic_bitset_view* mSource{};
+		};
+
+		using iterator = const_iterator;
+
+		constexpr basic_bitset_view() = default;
+
+		constexpr basic_bitset_view(const Block* blocks, size_t numOfBits) :
+			mBlocks(blocks),
+			mNumOfBits(numOfBits)
+		{}
+
+		constexpr basic_bitset_view(std::span<const Block> blocks, size_t numOfBits) :
+			mBlocks(blocks.data()),
+			mNumOfBits(numOfBits)
+		{
+			assert(detail::getNumOfBlocksNeeded<Block>(numOfBits) <= blocks.size());
+		}
+
+		// Views all of the bytes.
+		basic_bitset_view(std::span<const std::byte> bytes) requires (sizeof(Block) == 1) :
+			basic_bitset_view(bytes, bytes.size() * sNumOfBitsInByte)
+		{}
+
+		basic_bitset_view(std::span<const std::byte> bytes, size_t numOfBits) requires (sizeof(Block) == 1) :
+			basic_bitset_view(reinterpret_cast<const Block*>(bytes.data()), numOfBits)
+		{
+			assert(detail::getNumOfBlocksNeeded<Block>(numOfBits) <= bytes.size());
+		}
+
+		template<typename Container>
+		constexpr basic_bitset_view(const basic_dynamic_bitset<Block, Container>& bitset) :
+			mBlocks(bitset.data()),
+			mNumOfBits(bitset.size())
+		{}
+
+		constexpr const_iterator begin() const
+		{
+			return { this, 0, 0 };
+		}
+
+		constexpr const_iterator end() const
+		{
+			return { this, mNumOfBits / sNumOfBitsInByte, static_cast<bit_index>(mNumOfBits % sNumOfBitsInByte) };
+		}
+
+		constexpr bit get(byte_index byteIndex, bit_index bitIndex) const
+		{
+			const size_t bitPosition = byteIndex * sNumOfBitsInByte + bitIndex;
+
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitPosition < mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			return detail::getBit(mBlocks, bitPosition);
+		}
+
+		// Returns the bit the iterator is pointing too and increments the iterator
+		constexpr bit get(const_iterator& it) const
+		{
+			bit returnBit = it;
+			++it;
+			return returnBit;
+		}
+
+		// Creates and returns an instance of the type by using the next sizeof(type) bytes.
+		template <typename TriviablyCopyableType>
+		constexpr TriviablyCopyableType extract(byte_index byteIndex, bit_index bitIndex) const
+		{
+			const_iterator it = { this, byteIndex, bitIndex };
+			return extract<TriviablyCopyableType>(it);
+		}
+
+		// Creates and returns an instance of the type by using the next sizeof(type) bytes. Increments the iterator by the size of the type.
+		template <typename TriviablyCopyableType>
+		static constexpr TriviablyCopyableType extract(const_iterator& it)
+		{
+			static_assert(std::is_trivially_copyable<TriviablyCopyableType>::value);
+
+			constexpr size_t numOfBytes = sizeof(TriviablyCopyableType);
+
+			if (std::is_constant_evaluated())
+			{
+				std::array<char, numOfBytes> bytes{};
+				extract(bytes.data(), numOfBytes, it);
+				return std::bit_cast<TriviablyCopyableType>(bytes);
+			}
+
+			TriviablyCopyableType returnValue{};
+			extract(reinterpret_cast<char*>(&returnValue), numOfBytes, it);
+
+			return returnValue;
+		}
+
+		// Fills the destination with the bytes specified using the byteIndex and bitIndex
+		constexpr void extract(char* destination, size_t amountOfBytesToExtract, byte_index byteIndex, bit_index bitIndex) const
+		{
+			const_iterator it = { this, byteIndex, bitIndex };
+			extract(destination, amountOfBytesToExtract, it);
+		}
+
+		// Fills the destination with the bytes the iterator is pointing too and increments the iterator
+		static constexpr void extract(char* destination, size_t amountOfBytesToExtract, const_iterator& it)
+		{
+			const basic_bitset_view& source = *it.mSource;
+			const size_t bitIndex = it.getBitIndex();
+
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitIndex + amountOfBytesToExtract * sNumOfBitsInByte <= source.mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			if (std::is_constant_evaluated())
+			{
+				for (size_t i = 0; i < amountOfBytesToExtract; i++)
+				{
+					destination[i] = static_cast<char>(detail::readBits(source.mBlocks, bitIndex + i * sNumOfBitsInByte, sNumOfBitsInByte));
+				}
+			}
+			else
+			{
+				detail::readBytes(source.mBlocks, source.num_words(), bitIndex, reinterpret_cast<unsigned char*>(destination), amountOfBytesToExtract);
+			}
+			it.mByteIndex += amountOfBytesToExtract;
+		}
+
+		// Returns the next numOfBits (0 to 64) bits in the least significant bits of the return value, the bit
+		// the iterator is pointing to being the most significant of those. Increments the iterator by numOfBits.
+		static constexpr std::uint64_t read_bits(const_iterator& it, unsigned numOfBits)
+		{
+			assert(numOfBits <= detail::sNumOfBitsInWord);
+
+			if (numOfBits == 0)
+			{
+				return 0;
+			}
+
+			const size_t bitIndex = it.getBitIndex();
+
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitIndex + numOfBits <= it.mSource->mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			const std::uint64_t value = detail::readBits(it.mSource->mBlocks, bitIndex, numOfBits);
+			it += numOfBits;
+			return value;
+		}
+
+		// Returned by the find functions when there is no such bit.
+		static constexpr size_t npos = detail::sNotFound;
+
+		// Returns the index of the first set bit, or npos if no bits are set.
+		constexpr size_t find_first() const
+		{
+			return detail::findNext<true>(mBlocks, mNumOfBits, 0);
+		}
+
+		// Returns the index of the first set bit after bitIndex, or npos if there is none.
+		constexpr size_t find_next(size_t bitIndex) const
+		{
+			return bitIndex == npos ? npos : detail::findNext<true>(mBlocks, mNumOfBits, bitIndex + 1);
+		}
+
+		// Returns the index of the last set bit before bitIndex, or npos if there is none.
+		constexpr size_t find_prev(size_t bitIndex) const
+		{
+			return detail::findPreviousSetBit(mBlocks, bitIndex < mNumOfBits ? bitIndex : mNumOfBits);
+		}
+
+		// Returns the index of the first unset bit, or npos if all bits are set.
+		constexpr size_t find_first_zero() const
+		{
+			return detail::findNext<false>(mBlocks, mNumOfBits, 0);
+		}
+
+		// Returns the index of the first unset bit after bitIndex, or npos if there is none.
+		constexpr size_t find_next_zero(size_t bitIndex) const
+		{
+			return bitIndex == npos ? npos : detail::findNext<false>(mBlocks, mNumOfBits, bitIndex + 1);
+		}
+
+		// Calls the callback with the index of every set bit, in order.
+		template<typename Callback>
+		constexpr void for_each_set_bit(Callback&& callback) const
+		{
+			const size_t numOfBlocks = num_words();
+
+			for (size_t blockIndex = 0;; blockIndex++)
+			{
+				blockIndex = detail::skipEmptyBlocks(mBlocks, numOfBlocks, blockIndex);
+
+				if (blockIndex == numOfBlocks)
+				{
+					return;
+				}
+
+				Block value = mBlocks[blockIndex];
+
+				do
+				{
+					const size_t bitIndexInBlock = std::countl_zero(value);
+					const size_t bitIndex = blockIndex * sNumOfBitsInBlock + bitIndexInBlock;
+
+					// The bits past the last bit may be set.
+					if (bitIndex >= mNumOfBits)
+					{
+						return;
+					}
+
+					value = static_cast<Block>(value ^ (Block{ 1 } << (sNumOfBitsInBlock - 1 - bitIndexInBlock)));
+					callback(bitIndex);
+				} while (value != 0);
+			}
+		}
+
+		// Returns the number of set bits.
+		constexpr size_t count() const
+		{
+			return detail::countBits(mBlocks, 0, mNumOfBits);
+		}
+
+		// Returns the number of set bits from first up to, but not including, last.
+		constexpr size_t count(const_iterator first, const_iterator last) const
+		{
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(first.getBitIndex() <= last.getBitIndex() && last.getBitIndex() <= mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			// Only reads the blocks within the range, so that only those pages of a mapped file get loaded.
+			return detail::countBits(mBlocks, first.getBitIndex(), last.getBitIndex());
+		}
+
+		// Returns the number of set bits before the bit at bitIndex. bitIndex may be equal to the number of bits.
+		constexpr size_t rank(size_t bitIndex) const
+		{
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitIndex <= mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			return detail::countBits(mBlocks, 0, bitIndex);
+		}
+
+		// Returns the number of bits.
+		constexpr size_t size() const
+		{
+			return mNumOfBits;
+		}
+
+		// Returns the number of bytes the bits take up, counting an incomplete last byte as a whole byte.
+		constexpr size_t size_in_bytes() const
+		{
+			return detail::getNumOfBlocksNeeded<unsigned char>(mNumOfBits);
+		}
+
+		constexpr bool empty() const
+		{
+			return mNumOfBits == 0;
+		}
+
+		// Returns the number of blocks that hold bits.
+		constexpr size_t num_words() const
+		{
+			return detail::getNumOfBlocksNeeded<Block>(mNumOfBits);
+		}
+
+		constexpr const Block* data() const
+		{
+			return mBlocks;
+		}
+
+	private:
+		const Block* mBlocks{};
+		size_t mNumOfBits{};
+	};
+
+	using bitset_view = basic_bitset_view<>;
+
+#if defined(__unix__) || defined(__APPLE__)
+	// A read-only memory mapping of a whole file, which is unmapped again when this is destroyed. Throws a
+	// std::system_error when the file can't be opened or mapped.
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const char* path)
+		{
+			const int fileDescriptor = ::open(path, O_RDONLY | O_CLOEXEC);
+
+			if (fileDescriptor == -1)
+			{
+				throw std::system_error(errno, std::generic_category(), path);
+			}
+
+			struct stat status{};
+
+			if (::fstat(fileDescriptor, &status) == -1)
+			{
+				const int error = errno;
+				::close(fileDescriptor);
+				throw std::system_error(error, std::generic_category(), path);
+			}
+
+			mSize = static_cast<size_t>(status.st_size);
+
+			// Mapping zero bytes fails, an empty file is simply an empty mapping.
+			if (mSize > 0)
+			{
+				void* const mapping = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+
+				if (mapping == MAP_FAILED)
+				{
+					const int error = errno;
+					::close(fileDescriptor);
+					throw std::system_error(error, std::generic_category(), path);
+				}
+				mMapping = mapping;
+			}
+
+			// The mapping stays valid after closing the file.
+			::close(fileDescriptor);
+		}
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		mapped_file(mapped_file&& other) noexcept :
+			mMapping(std::exchange(other.mMapping, nullptr)),
+			mSize(std::exchange(other.mSize, 0))
+		{}
+
+		mapped_file& operator=(mapped_file&& other) noexcept
+		{
+			if (this != &other)
+			{
+				unmap();
+				mMapping = std::exchange(other.mMapping, nullptr);
+				mSize = std::exchange(other.mSize, 0);
+			}
+			return *this;
+		}
+
+		~mapped_file()
+		{
+			unmap();
+		}
+
+		// The contents of the file, page aligned.
+		std::span<const std::byte> bytes() const
+		{
+			return { static_cast<const std::byte*>(mMapping), mSize };
+		}
+
+	private:
+		void unmap()
+		{
+			if (mMapping != nullptr)
+			{
+				::munmap(mMapping, mSize);
+				mMapping = nullptr;
+			}
+		}
+
+		void* mMapping{};
+		size_t mSize{};
+	};
+
+	// A read-only bitset_view of a file that is memory mapped rather than read, so opening it costs the
+	// same no matter the size of the file and only the pages that are accessed are loaded. Throws a
+	// std::system_error when the file can't be opened or mapped.
+	class mapped_bitset :
+		public bitset_view
+	{
+	public:
+		// Views every byte of the file.
+		explicit mapped_bitset(const char* path) :
+			bitset_view(),
+			mFile(path)
+		{
+			static_cast<bitset_view&>(*this) = { mFile.bytes() };
+		}
+
+		// Views the first numOfBits bits of the file, which needs to be large enough for those.
+		mapped_bitset(const char* path, size_t numOfBits) :
+			bitset_view(),
+			mFile(path)
+		{
+			if (detail::getNumOfBlocksNeeded<unsigned char>(numOfBits) > mFile.bytes().size())
+			{
+				throw std::system_error(std::make_error_code(std::errc::invalid_argument), "File is smaller than the number of bits");
+			}
+			static_cast<bitset_view&>(*this) = { mFile.bytes(), numOfBits };
+		}
+
+		mapped_bitset(mapped_bitset&& other) noexcept :
+			bitset_view(std::exchange(static_cast<bitset_view&>(other), {})),
+			mFile(std::move(other.mFile))
+		{}
+
+		mapped_bitset& operator=(mapped_bitset&& other) noexcept
+		{
+			static_cast<bitset_view&>(*this) = std::exchange(static_cast<bitset_view&>(other), {});
+			mFile = std::move(other.mFile);
+			return *this;
+		}
+
+	private:
+		mapped_file mFile;
+	};
+#endif // __unix__ || __APPLE__
+}
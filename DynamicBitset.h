@@ -1,7 +1,24 @@
 #pragma once
+#include <array>
+#include <bit>
 #include <cassert>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*
 MIT License
 
@@ -34,36 +51,57 @@ namespace DB
 
 	constexpr bit_index sNumOfBitsInByte = 8;
 
-	class byte;
-	class dynamic_bitset;
+	template<typename Type>
+	constexpr size_t sNumOfBitsInType = sizeof(Type) * sNumOfBitsInByte;
 
-	// Changing the value of a bitref also updates the value in the byte that it's from.
-	// The value will always match the one from the byte that it's originally from.
-	// Will lead to undefined behaviour if the byte gets destroyed or moved (e.g. when 
-	// the underlying vector of a dynamic_bitset resizes.).
-	class bit_ref
+	// Changing the value of a bitref also updates the value in the block that it's from.
+	// The value will always match the one from the block that it's originally from.
+	// Will lead to undefined behaviour if the block gets destroyed or moved (e.g. when 
+	// the underlying container of a dynamic_bitset resizes.).
+	template<typename Block>
+	class basic_bit_ref
 	{
 	public:
-		bit_ref(byte& owner, bit_index indexAtOwner) :
+		constexpr basic_bit_ref(Block& owner, bit_index indexAtOwner) :
 			mOwner(owner),
 			mIndexAtOwner(indexAtOwner)
 		{}
 
-		inline operator bit() const;
-		inline void operator=(bit value);
+		constexpr operator bit() const
+		{
+			return (mOwner >> getShiftAmount()) & 1;
+		}
+
+		constexpr void operator=(bit value)
+		{
+			const Block mask = static_cast<Block>(Block{ 1 } << getShiftAmount());
+			mOwner = static_cast<Block>((mOwner & ~mask) | (static_cast<Block>(value) << getShiftAmount()));
+		}
 
 	private:
-		byte& mOwner;
+		constexpr bit_index getShiftAmount() const
+		{
+#if _CONTAINER_DEBUG_LEVEL > 0
+			assert(mIndexAtOwner < sNumOfBitsInType<Block>);
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+
+			return sNumOfBitsInType<Block> - mIndexAtOwner - 1;
+		}
+
+		Block& mOwner;
 		bit_index mIndexAtOwner{};
 	};
 
+	// A reference to a bit of a DB::byte.
+	using byte_bit_ref = basic_bit_ref<unsigned char>;
+
 	class byte
 	{
 	public:
-		byte() = default;
-		byte(unsigned char data) : mData(data) {}
+		constexpr byte() = default;
+		constexpr byte(unsigned char data) : mData(data) {}
 
-		inline void set(const bit_index index, bit bit)
+		constexpr void set(const bit_index index, bit bit)
 		{
 #if _CONTAINER_DEBUG_LEVEL > 0
 			assert(index < sNumOfBitsInByte);
@@ -73,7 +111,7 @@ namespace DB
 			mData = (mData & ~(1 << shiftAmount)) + (bit << shiftAmount);
 		}
 
-		inline bit get(const bit_index index) const
+		constexpr bit get(const bit_index index) const
 		{
 #if _CONTAINER_DEBUG_LEVEL > 0
 			assert(index < sNumOfBitsInByte);
@@ -83,13 +121,13 @@ namespace DB
 			return (mData & (1 << shiftAmount)) >> shiftAmount;
 		}
 
-		inline bit_ref getBitRef(const bit_index index)
+		constexpr byte_bit_ref getBitRef(const bit_index index)
 		{
-			return { *this, index };
+			return { mData, index };
 		}
 
-		inline operator unsigned char& () { return mData; }
-		inline operator const unsigned char() const { return mData; }
+		constexpr operator unsigned char& () { return mData; }
+		constexpr operator const unsigned char() const { return mData; }
 
 	private:
 		unsigned char mData{};
@@ -97,37 +135,585 @@ namespace DB
 
 	static_assert(sizeof(byte) == 1);
 
-	inline bit_ref::operator bit() const
+	namespace detail
 	{
-		return mOwner.get(mIndexAtOwner);
-	}
+		template<typename Block>
+		constexpr size_t getNumOfBlocksNeeded(size_t numOfBits)
+		{
+			return (numOfBits + sNumOfBitsInType<Block> - 1) / sNumOfBitsInType<Block>;
+		}
 
-	inline void bit_ref::operator=(bit value)
-	{
-		mOwner.set(mIndexAtOwner, value);
-	}
+		// Bit 0 is the most significant bit of the first block, bit 1 the one after that, etc.
+		template<typename Block>
+		constexpr bit getBit(const Block* blocks, size_t bitIndex)
+		{
+			const size_t shiftAmount = sNumOfBitsInType<Block> - bitIndex % sNumOfBitsInType<Block> - 1;
+			return (blocks[bitIndex / sNumOfBitsInType<Block>] >> shiftAmount) & 1;
+		}
 
-	// The bits here are stored as part of chars, which in turn are stored inside a vector. This
-	// ensures that 1 bit is actually taking up the space of 1 bit, as opposed to std::bitset.
-	// This also meanst that getting/retrieving values is going to be slower than std::bitset. If 
-	// you know at compile time what size the bitset is going to be, it is highly recommended to 
-	// use std::bitset. If you don't need to store/retrieve triviably copyable types in binary 
-	// format, it is highly recommned to use std::vector<bool>.
-	class dynamic_bitset
-	{
+		template<typename Block>
+		constexpr void setBit(Block* blocks, size_t bitIndex, bit value)
+		{
+			basic_bit_ref<Block> ref{ blocks[bitIndex / sNumOfBitsInType<Block>], static_cast<bit_index>(bitIndex % sNumOfBitsInType<Block>) };
+			ref = value;
+		}
+
+		using word = std::uint64_t;
+		constexpr size_t sNumOfBitsInWord = sNumOfBitsInType<word>;
+
+		// Returns a word with the numOfBits least significant bits set, numOfBits may be 0 to 64.
+		constexpr word getLowMask(size_t numOfBits)
+		{
+			return numOfBits >= sNumOfBitsInWord ? ~word{} : (word{ 1 } << numOfBits) - 1;
+		}
+
+		// Interprets the bytes as a big endian number, so that the first bit of the first byte ends 
+		// up as the most significant bit. Compilers turn this into a single load and byte swap.
+		constexpr word loadBigEndian(const unsigned char* bytes)
+		{
+			return static_cast<word>(bytes[0]) << 56
+				| static_cast<word>(bytes[1]) << 48
+				| static_cast<word>(bytes[2]) << 40
+				| static_cast<word>(bytes[3]) << 32
+				| static_cast<word>(bytes[4]) << 24
+				| static_cast<word>(bytes[5]) << 16
+				| static_cast<word>(bytes[6]) << 8
+				| static_cast<word>(bytes[7]);
+		}
+
+		// Same as above, but for fewer than 8 bytes. These end up in the numOfBytes * 8 least significant bits.
+		constexpr word loadBigEndian(const unsigned char* bytes, size_t numOfBytes)
+		{
+			word value{};
+			for (size_t i = 0; i < numOfBytes; i++)
+			{
+				value = (value << sNumOfBitsInByte) | bytes[i];
+			}
+			return value;
+		}
+
+		constexpr void storeBigEndian(unsigned char* bytes, word value)
+		{
+			bytes[0] = static_cast<unsigned char>(value >> 56);
+			bytes[1] = static_cast<unsigned char>(value >> 48);
+			bytes[2] = static_cast<unsigned char>(value >> 40);
+			bytes[3] = static_cast<unsigned char>(value >> 32);
+			bytes[4] = static_cast<unsigned char>(value >> 24);
+			bytes[5] = static_cast<unsigned char>(value >> 16);
+			bytes[6] = static_cast<unsigned char>(value >> 8);
+			bytes[7] = static_cast<unsigned char>(value);
+		}
+
+		// Stores the numOfBytes * 8 least significant bits, the counterpart of the partial loadBigEndian.
+		constexpr void storeBigEndian(unsigned char* bytes, word value, size_t numOfBytes)
+		{
+			for (size_t i = numOfBytes; i > 0; i--)
+			{
+				bytes[i - 1] = static_cast<unsigned char>(value);
+				value >>= sNumOfBitsInByte;
+			}
+		}
+
+		// Returns the numOfBits (1 to 64) bits starting at bitIndex in the least significant bits, the 
+		// bit at bitIndex being the most significant of those.
+		template<typename Block>
+		constexpr word readBits(const Block* blocks, size_t bitIndex, size_t numOfBits)
+		{
+			constexpr size_t numOfBitsInBlock = sNumOfBitsInType<Block>;
+			size_t blockIndex = bitIndex / numOfBitsInBlock;
+			const size_t bitIndexInBlock = bitIndex % numOfBitsInBlock;
+
+			if constexpr (numOfBitsInBlock == sNumOfBitsInWord)
+			{
+				// Funnel shift, the bits come from at most two blocks.
+				word value = blocks[blockIndex] << bitIndexInBlock;
+
+				if (bitIndexInBlock + numOfBits > sNumOfBitsInWord)
+				{
+					value |= blocks[blockIndex + 1] >> (sNumOfBitsInWord - bitIndexInBlock);
+				}
+
+				return value >> (sNumOfBitsInWord - numOfBits);
+			}
+			else
+			{
+				size_t numOfBitsAvailable = numOfBitsInBlock - bitIndexInBlock;
+				size_t numOfBitsRemaining = numOfBits;
+				word value{};
+
+				while (numOfBitsRemaining > 0)
+				{
+					const size_t numOfBitsToRead = numOfBitsAvailable < numOfBitsRemaining ? numOfBitsAvailable : numOfBitsRemaining;
+					numOfBitsRemaining -= numOfBitsToRead;
+
+					const word chunk = static_cast<word>(blocks[blockIndex++]) >> (numOfBitsAvailable - numOfBitsToRead);
+					value = (value << numOfBitsToRead) | (chunk & getLowMask(numOfBitsToRead));
+					numOfBitsAvailable = numOfBitsInBlock;
+				}
+
+				return value;
+			}
+		}
+
+		// Returns the 64 bits of the word at wordIndex of a bitset of numOfBits bits, left aligned like a 
+		// 64 bit block, the bits past the end of the bitset are zero.
+		template<typename Block>
+		constexpr word getWord(const Block* blocks, size_t numOfBits, size_t wordIndex)
+		{
+			const size_t bitIndex = wordIndex * sNumOfBitsInWord;
+			const size_t numOfBitsInWord = numOfBits - bitIndex < sNumOfBitsInWord ? numOfBits - bitIndex : sNumOfBitsInWord;
+			return readBits(blocks, bitIndex, numOfBitsInWord) << (sNumOfBitsInWord - numOfBitsInWord);
+		}
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+		// Writes 32 or 64 bytes per iteration for as long as there are enough words left, the words at
+		// wordIndex and the one after are funnel shifted together and byte swapped back to memory order.
+		// Returns the number of bytes written.
+		inline size_t readBytesSimd(const word* words, size_t numOfWords, size_t bitIndex, unsigned char* destination, size_t numOfBytes)
+		{
+			size_t wordIndex = bitIndex / sNumOfBitsInWord;
+			const __m128i leftShift = _mm_cvtsi64_si128(static_cast<long long>(bitIndex % sNumOfBitsInWord));
+			const __m128i rightShift = _mm_cvtsi64_si128(static_cast<long long>(sNumOfBitsInWord - bitIndex % sNumOfBitsInWord));
+			size_t i = 0;
+
+#if defined(__AVX512BW__)
+			// The zero masked forms with every lane selected do the same as the unmasked ones, but start from a
+			// zeroed rather than an undefined vector, which GCC 12 warns about.
+			constexpr __mmask16 allLanes32 = 0xFFFF;
+			constexpr __mmask8 allLanes64 = 0xFF;
+			const __m512i byteSwap = _mm512_maskz_broadcast_i32x4(allLanes32, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+
+			for (; i + sizeof(__m512i) <= numOfBytes && wordIndex + 9 <= numOfWords; i += sizeof(__m512i), wordIndex += 8)
+			{
+				const __m512i current = _mm512_loadu_si512(words + wordIndex);
+				const __m512i next = _mm512_loadu_si512(words + wordIndex + 1);
+				const __m512i funnelled = _mm512_or_si512(_mm512_maskz_sll_epi64(allLanes64, current, leftShift), _mm512_maskz_srl_epi64(allLanes64, next, rightShift));
+				_mm512_storeu_si512(destination + i, _mm512_shuffle_epi8(funnelled, byteSwap));
+			}
+#else
+			const __m256i byteSwap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+				7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+			for (; i + sizeof(__m256i) <= numOfBytes && wordIndex + 5 <= numOfWords; i += sizeof(__m256i), wordIndex += 4)
+			{
+				const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + wordIndex));
+				const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + wordIndex + 1));
+				const __m256i funnelled = _mm256_or_si256(_mm256_sll_epi64(current, leftShift), _mm256_srl_epi64(next, rightShift));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_shuffle_epi8(funnelled, byteSwap));
+			}
+#endif
+			return i;
+		}
+#endif // __AVX512BW__ || __AVX2__
+
+		// Copies numOfBytes bytes starting at any bitIndex into the destination, a word at a time. When the
+		// blocks are bytes and the bitIndex is byte aligned, the bytes are already in the right order.
+		template<typename Block>
+		constexpr void readBytes(const Block* blocks, size_t numOfBlocks, size_t bitIndex, unsigned char* destination, size_t numOfBytes)
+		{
+			// The destination and the blocks may be null when there is nothing to copy, which memcpy doesn't allow.
+			if (numOfBytes == 0)
+			{
+				return;
+			}
+
+			if constexpr (sizeof(Block) == 1)
+			{
+				if (bitIndex % sNumOfBitsInByte == 0 && !std::is_constant_evaluated())
+				{
+					std::memcpy(destination, blocks + bitIndex / sNumOfBitsInByte, numOfBytes);
+					return;
+				}
+			}
+
+			constexpr size_t numOfBytesInWord = sizeof(word);
+			size_t i = 0;
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+			if constexpr (std::is_same<Block, word>::value)
+			{
+				if (!std::is_constant_evaluated())
+				{
+					i = readBytesSimd(blocks, numOfBlocks, bitIndex, destination, numOfBytes);
+					bitIndex += i * sNumOfBitsInByte;
+				}
+			}
+#else
+			(void)numOfBlocks;
+#endif // __AVX512BW__ || __AVX2__
+
+			for (; i + numOfBytesInWord <= numOfBytes; i += numOfBytesInWord, bitIndex += sNumOfBitsInWord)
+			{
+				storeBigEndian(destination + i, readBits(blocks, bitIndex, sNumOfBitsInWord));
+			}
+
+			const size_t numOfBytesRemaining = numOfBytes - i;
+
+			if (numOfBytesRemaining > 0)
+			{
+				storeBigEndian(destination + i, readBits(blocks, bitIndex, numOfBytesRemaining * sNumOfBitsInByte), numOfBytesRemaining);
+			}
+		}
+
+		// Counts the set bits in the bytes, the order of the bits does not matter for this.
+		inline size_t countBitsInBytes(const unsigned char* bytes, size_t numOfBytes)
+		{
+			size_t numOfSetBits{};
+			size_t i = 0;
+
+#if defined(__AVX512VPOPCNTDQ__)
+			__m512i sums = _mm512_setzero_si512();
+
+			for (; i + sizeof(__m512i) <= numOfBytes; i += sizeof(__m512i))
+			{
+				sums = _mm512_add_epi64(sums, _mm512_popcnt_epi64(_mm512_loadu_si512(bytes + i)));
+			}
+			alignas(sizeof(__m512i)) std::uint64_t sumsPerLane[8];
+			_mm512_store_si512(sumsPerLane, sums);
+
+			for (const std::uint64_t sum : sumsPerLane)
+			{
+				numOfSetBits += sum;
+			}
+#elif defined(__AVX2__)
+			// Looks up the number of set bits of each nibble, then sums the bytes of each word.
+			const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+				0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+			__m256i sums = _mm256_setzero_si256();
+
+			for (; i + sizeof(__m256i) <= numOfBytes; i += sizeof(__m256i))
+			{
+				const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+				const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(data, lowNibbles));
+				const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(data, 4), lowNibbles));
+				sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+			}
+			numOfSetBits += static_cast<size_t>(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1)
+				+ _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+#endif // __AVX512VPOPCNTDQ__
+
+			for (; i + sizeof(word) <= numOfBytes; i += sizeof(word))
+			{
+				word value;
+				std::memcpy(&value, bytes + i, sizeof(word));
+				numOfSetBits += std::popcount(value);
+			}
+
+			for (; i < numOfBytes; i++)
+			{
+				numOfSetBits += std::popcount(bytes[i]);
+			}
+
+			return numOfSetBits;
+		}
+
+		// Counts the set bits from firstBitIndex up to, but not including, lastBitIndex.
+		template<typename Block>
+		constexpr size_t countBits(const Block* blocks, size_t firstBitIndex, size_t lastBitIndex)
+		{
+			if (firstBitIndex >= lastBitIndex)
+			{
+				return 0;
+			}
+
+			constexpr size_t numOfBitsInBlock = sNumOfBitsInType<Block>;
+			constexpr Block allBits = static_cast<Block>(~Block{});
+
+			const size_t firstBlockIndex = firstBitIndex / numOfBitsInBlock;
+			const size_t lastBlockIndex = (lastBitIndex - 1) / numOfBitsInBlock;
+			const Block firstMask = static_cast<Block>(allBits >> (firstBitIndex % numOfBitsInBlock));
+			const Block lastMask = static_cast<Block>(allBits << (numOfBitsInBlock - 1 - (lastBitIndex - 1) % numOfBitsInBlock));
+
+			if (firstBlockIndex == lastBlockIndex)
+			{
+				return std::popcount(static_cast<Block>(blocks[firstBlockIndex] & firstMask & lastMask));
+			}
+
+			size_t numOfSetBits = std::popcount(static_cast<Block>(blocks[firstBlockIndex] & firstMask))
+				+ std::popcount(static_cast<Block>(blocks[lastBlockIndex] & lastMask));
+
+			if (std::is_constant_evaluated())
+			{
+				for (size_t blockIndex = firstBlockIndex + 1; blockIndex < lastBlockIndex; blockIndex++)
+				{
+					numOfSetBits += std::popcount(blocks[blockIndex]);
+				}
+				return numOfSetBits;
+			}
+
+			return numOfSetBits + countBitsInBytes(reinterpret_cast<const unsigned char*>(blocks + firstBlockIndex + 1), (lastBlockIndex - firstBlockIndex - 1) * sizeof(Block));
+		}
+
+		constexpr size_t sNotFound = static_cast<size_t>(-1);
+
+		// Returns the index of the first block at or after blockIndex that has a bit with the value, or 
+		// numOfBlocks if there is none. Skips a word's worth of blocks at a time if blocks are smaller than that.
+		template<bit Value = true, typename Block>
+		constexpr size_t skipEmptyBlocks(const Block* blocks, size_t numOfBlocks, size_t blockIndex)
+		{
+			constexpr Block emptyBlock = Value ? Block{} : static_cast<Block>(~Block{});
+
+			if constexpr (sizeof(Block) < sizeof(word))
+			{
+				constexpr size_t numOfBlocksInWord = sizeof(word) / sizeof(Block);
+				constexpr word emptyWord = Value ? word{} : ~word{};
+
+				for (word chunk; blockIndex + numOfBlocksInWord <= numOfBlocks && !std::is_constant_evaluated(); blockIndex += numOfBlocksInWord)
+				{
+					std::memcpy(&chunk, blocks + blockIndex, sizeof(word));
+					if (chunk != emptyWord)
+					{
+						break;
+					}
+				}
+			}
+
+			while (blockIndex < numOfBlocks && blocks[blockIndex] == emptyBlock)
+			{
+				blockIndex++;
+			}
+			return blockIndex;
+		}
+
+		// Returns the index of the first bit at or after bitIndex that has the value, or sNotFound.
+		template<bit Value, typename Block>
+		constexpr size_t findNext(const Block* blocks, size_t numOfBits, size_t bitIndex)
+		{
+			if (bitIndex >= numOfBits)
+			{
+				return sNotFound;
+			}
+
+			constexpr size_t numOfBitsInBlock = sNumOfBitsInType<Block>;
+			constexpr Block allBits = static_cast<Block>(~Block{});
+			const size_t numOfBlocks = getNumOfBlocksNeeded<Block>(numOfBits);
+
+			// Looking for unset bits is the same as looking for set bits in the inverted blocks.
+			const auto getBlock = [blocks](size_t blockIndex) { return static_cast<Block>(Value ? blocks[blockIndex] : ~blocks[blockIndex]); };
+
+			size_t blockIndex = bitIndex / numOfBitsInBlock;
+			Block value = static_cast<Block>(getBlock(blockIndex) & (allBits >> (bitIndex % numOfBitsInBlock)));
+
+			if (value == 0)
+			{
+				blockIndex = skipEmptyBlocks<Value>(blocks, numOfBlocks, blockIndex + 1);
+
+				if (blockIndex == numOfBlocks)
+				{
+					return sNotFound;
+				}
+				value = getBlock(blockIndex);
+			}
+
+			// The inverted bits past the end are set, these don't count.
+			const size_t foundBitIndex = blockIndex * numOfBitsInBlock + std::countl_zero(value);
+			return foundBitIndex < numOfBits ? foundBitIndex : sNotFound;
+		}
+
+		// Returns the index of the last set bit before bitIndex, or sNotFound.
+		template<typename Block>
+		constexpr size_t findPreviousSetBit(const Block* blocks, size_t bitIndex)
+		{
+			if (bitIndex == 0)
+			{
+				return sNotFound;
+			}
+
+			constexpr size_t numOfBitsInBlock = sNumOfBitsInType<Block>;
+			constexpr Block allBits = static_cast<Block>(~Block{});
+			const size_t lastBitIndex = bitIndex - 1;
+
+			size_t blockIndex = lastBitIndex / numOfBitsInBlock;
+			Block value = static_cast<Block>(blocks[blockIndex] & (allBits << (numOfBitsInBlock - 1 - lastBitIndex % numOfBitsInBlock)));
+
+			while (value == 0)
+			{
+				if (blockIndex-- == 0)
+				{
+					return sNotFound;
+				}
+				value = blocks[blockIndex];
+			}
+
+			return blockIndex * numOfBitsInBlock + numOfBitsInBlock - 1 - std::countr_zero(value);
+		}
+
+		enum class BitwiseOperation
+		{
+			And,
+			Or,
+			Xor,
+			AndNot
+		};
+
+		template<BitwiseOperation Operation, typename Type>
+		constexpr Type combine(Type destination, Type source)
+		{
+			if constexpr (Operation == BitwiseOperation::And) return destination & source;
+			else if constexpr (Operation == BitwiseOperation::Or) return destination | source;
+			else if constexpr (Operation == BitwiseOperation::Xor) return destination ^ source;
+			else return destination & ~source;
+		}
+
+#if defined(__AVX512F__)
+		template<BitwiseOperation Operation>
+		inline __m512i combine(__m512i destination, __m512i source)
+		{
+			if constexpr (Operation == BitwiseOperation::And) return _mm512_and_si512(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Or) return _mm512_or_si512(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Xor) return _mm512_xor_si512(destination, source);
+			else return _mm512_and_si512(destination, _mm512_xor_si512(source, _mm512_set1_epi64(-1)));
+		}
+#elif defined(__AVX2__)
+		template<BitwiseOperation Operation>
+		inline __m256i combine(__m256i destination, __m256i source)
+		{
+			if constexpr (Operation == BitwiseOperation::And) return _mm256_and_si256(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Or) return _mm256_or_si256(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Xor) return _mm256_xor_si256(destination, source);
+			else return _mm256_andnot_si256(source, destination);
+		}
+#elif defined(__ARM_NEON)
+		template<BitwiseOperation Operation>
+		inline uint8x16_t combine(uint8x16_t destination, uint8x16_t source)
+		{
+			if constexpr (Operation == BitwiseOperation::And) return vandq_u8(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Or) return vorrq_u8(destination, source);
+			else if constexpr (Operation == BitwiseOperation::Xor) return veorq_u8(destination, source);
+			else return vbicq_u8(destination, source);
+		}
+#endif
+
+		// Applies the operation to each byte of the destination and the byte at the same index in the source.
+		// Bitwise operations don't care about the order of the bits, so this works for every type of block.
+		template<BitwiseOperation Operation>
+		inline void combineBytes(unsigned char* destination, const unsigned char* source, size_t numOfBytes)
+		{
+			size_t i = 0;
+
+#if defined(__AVX512F__)
+			for (; i + sizeof(__m512i) <= numOfBytes; i += sizeof(__m512i))
+			{
+				const __m512i result = combine<Operation>(_mm512_loadu_si512(destination + i), _mm512_loadu_si512(source + i));
+				_mm512_storeu_si512(destination + i, result);
+			}
+#elif defined(__AVX2__)
+			for (; i + sizeof(__m256i) <= numOfBytes; i += sizeof(__m256i))
+			{
+				const __m256i result = combine<Operation>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + i)),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), result);
+			}
+#elif defined(__ARM_NEON)
+			for (; i + sizeof(uint8x16_t) <= numOfBytes; i += sizeof(uint8x16_t))
+			{
+				vst1q_u8(destination + i, combine<Operation>(vld1q_u8(destination + i), vld1q_u8(source + i)));
+			}
+#endif
+
+			for (; i + sizeof(word) <= numOfBytes; i += sizeof(word))
+			{
+				word destinationWord, sourceWord;
+				std::memcpy(&destinationWord, destination + i, sizeof(word));
+				std::memcpy(&sourceWord, source + i, sizeof(word));
+				destinationWord = combine<Operation>(destinationWord, sourceWord);
+				std::memcpy(destination + i, &destinationWord, sizeof(word));
+			}
+
+			for (; i < numOfBytes; i++)
+			{
+				destination[i] = combine<Operation>(destination[i], source[i]);
+			}
+		}
+
+		// ORs the numOfBits (1 to 64) least significant bits of value into the bits starting at bitIndex,
+		// most significant bit first. The destination bits are expected to be zero.
+		template<typename Block>
+		constexpr void orBits(Block* blocks, size_t bitIndex, word value, size_t numOfBits)
+		{
+			constexpr size_t numOfBitsInBlock = sNumOfBitsInType<Block>;
+			size_t blockIndex = bitIndex / numOfBitsInBlock;
+			const size_t bitIndexInBlock = bitIndex % numOfBitsInBlock;
+
+			if constexpr (numOfBitsInBlock == sNumOfBitsInWord)
+			{
+				// Shift and merge, the bits end up in at most two blocks.
+				const word leftAligned = value << (sNumOfBitsInWord - numOfBits);
+				blocks[blockIndex] |= leftAligned >> bitIndexInBlock;
+
+				if (bitIndexInBlock + numOfBits > sNumOfBitsInWord)
+				{
+					blocks[blockIndex + 1] |= leftAligned << (sNumOfBitsInWord - bitIndexInBlock);
+				}
+			}
+			else
+			{
+				size_t numOfBitsAvailable = numOfBitsInBlock - bitIndexInBlock;
+				size_t numOfBitsRemaining = numOfBits;
+
+				while (numOfBitsRemaining > 0)
+				{
+					const size_t numOfBitsToWrite = numOfBitsAvailable < numOfBitsRemaining ? numOfBitsAvailable : numOfBitsRemaining;
+					numOfBitsRemaining -= numOfBitsToWrite;
+
+					const word chunk = (value >> numOfBitsRemaining) & getLowMask(numOfBitsToWrite);
+					blocks[blockIndex++] |= static_cast<Block>(chunk << (numOfBitsAvailable - numOfBitsToWrite));
+					numOfBitsAvailable = numOfBitsInBlock;
+				}
+			}
+		}
+
+		// ORs the bytes into the bits starting at bitIndex, a word at a time. The destination bits are 
+		// expected to be zero.
+		template<typename Block>
+		constexpr void orBytes(Block* blocks, size_t bitIndex, const unsigned char* source, size_t numOfBytes)
+		{
+			if (numOfBytes == 0)
+			{
+				return;
+			}
+
+			if constexpr (sizeof(Block) == 1)
+			{
+				if (bitIndex % sNumOfBitsInByte == 0 && !std::is_constant_evaluated())
+				{
+					std::memcpy(blocks + bitIndex / sNumOfBitsInByte, source, numOfBytes);
+					return;
+				}
+			}
+
+			constexpr size_t numOfBytesInWord = sizeof(word);
+			size_t i = 0;
+
+			for (; i + numOfBytesInWord <= numOfBytes; i += numOfBytesInWord, bitIndex += sNumOfBitsInWord)
+			{
+				orBits(blocks, bitIndex, loadBigEndian(source + i), sNumOfBitsInWord);
+			}
+
+			const size_t numOfBytesRemaining = numOfBytes - i;
+
+			if (numOfBytesRemaining > 0)
+			{
+				orBits(blocks, bitIndex, loadBigEndian(source + i, numOfBytesRemaining), numOfBytesRemaining * sNumOfBitsInByte);
+			}
+		}
+
+		// The position and arithmetic shared by the bitset iterators. The position is kept as a byte and
+		// a bit index, as that is what get() and extract() take.
 		template<typename DerivedType>
 		class IteratorBase
 		{
 		public:
-			IteratorBase() = default;
-			IteratorBase(byte_index byteIndex, bit_index bitIndex) : mByteIndex(byteIndex), mBitIndex(bitIndex) {}
+			constexpr IteratorBase() = default;
+			constexpr IteratorBase(byte_index byteIndex, bit_index bitIndex) : mByteIndex(byteIndex), mBitIndex(bitIndex) {}
 
 			using value_type = bit;
 			using difference_type = std::ptrdiff_t;
-			using iterator_category = std::forward_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
 
 			// Prefix increment
-			DerivedType& operator++()
+			constexpr DerivedType& operator++()
 			{
 				if (++mBitIndex == 8)
 				{
@@ -138,224 +724,457 @@ namespace DB
 			}
 
 			// Postfix increment
-			DerivedType operator++(int)
+			constexpr DerivedType operator++(int)
 			{
 				DerivedType tmp = *static_cast<DerivedType*>(this);
 				++(*this);
 				return tmp;
 			}
 
-			friend bool operator== (const IteratorBase& a, const IteratorBase& b)
+			// Prefix decrement
+			constexpr DerivedType& operator--()
+			{
+				if (mBitIndex-- == 0)
+				{
+					mBitIndex = sNumOfBitsInByte - 1;
+					--mByteIndex;
+				}
+				return *static_cast<DerivedType*>(this);
+			}
+
+			// Postfix decrement
+			constexpr DerivedType operator--(int)
+			{
+				DerivedType tmp = *static_cast<DerivedType*>(this);
+				--(*this);
+				return tmp;
+			}
+
+			// Jumps straight to the bit, without stepping through the ones in between.
+			constexpr DerivedType& operator+=(difference_type numOfBits)
+			{
+				const size_t bitIndex = getBitIndex() + static_cast<size_t>(numOfBits);
+				mByteIndex = bitIndex / sNumOfBitsInByte;
+				mBitIndex = static_cast<bit_index>(bitIndex % sNumOfBitsInByte);
+				return *static_cast<DerivedType*>(this);
+			}
+
+			constexpr DerivedType& operator-=(difference_type numOfBits)
+			{
+				return *this += -numOfBits;
+			}
+
+			// The offset is a template so that it is an exact match; otherwise the implicit
+			// conversion of the iterators to bit makes "it + 1" ambiguous with the built-in operator.
+			template<std::integral Offset>
+			friend constexpr DerivedType operator+(DerivedType it, Offset numOfBits)
+			{
+				return it += numOfBits;
+			}
+
+			template<std::integral Offset>
+			friend constexpr DerivedType operator+(Offset numOfBits, DerivedType it)
+			{
+				return it += numOfBits;
+			}
+
+			template<std::integral Offset>
+			friend constexpr DerivedType operator-(DerivedType it, Offset numOfBits)
+			{
+				return it -= numOfBits;
+			}
+
+			friend constexpr difference_type operator-(const DerivedType& a, const DerivedType& b)
+			{
+				return static_cast<difference_type>(a.getBitIndex()) - static_cast<difference_type>(b.getBitIndex());
+			}
+
+			constexpr auto operator[](difference_type numOfBits) const
+			{
+				return *(*static_cast<const DerivedType*>(this) + numOfBits);
+			}
+
+			friend constexpr bool operator== (const IteratorBase& a, const IteratorBase& b)
 			{
 				return a.mByteIndex == b.mByteIndex
 					&& a.mBitIndex == b.mBitIndex;
 			};
-			friend bool operator!= (const IteratorBase& a, const IteratorBase& b)
+			friend constexpr bool operator!= (const IteratorBase& a, const IteratorBase& b)
 			{
 				return a.mByteIndex != b.mByteIndex
 					|| a.mBitIndex != b.mBitIndex;
 			};
 
-			inline bool operator<(const IteratorBase& other)
+			friend constexpr auto operator<=>(const IteratorBase& a, const IteratorBase& b)
 			{
-				return mByteIndex < other.mByteIndex
-					|| (mByteIndex == other.mByteIndex && mBitIndex < other.mBitIndex);
+				return a.getBitIndex() <=> b.getBitIndex();
 			}
+
 		protected:
+			constexpr size_t getBitIndex() const
+			{
+				return mByteIndex * sNumOfBitsInByte + mBitIndex;
+			}
+
 			byte_index mByteIndex{};
 			bit_index mBitIndex{};
 		};
 
+		// The allocator_type of containers that don't allocate, e.g. static_block_vector.
+		struct NoAllocator {};
+
+		template<typename Container>
+		concept AllocatorAware = requires { typename Container::allocator_type; };
+
+		template<typename Container>
+		struct AllocatorOf
+		{
+			using type = NoAllocator;
+		};
+
+		template<AllocatorAware Container>
+		struct AllocatorOf<Container>
+		{
+			using type = typename Container::allocator_type;
+		};
+	}
+
+	// The bits here are stored as part of blocks, which in turn are stored inside a container. This
+	// ensures that 1 bit is actually taking up the space of 1 bit, as opposed to std::bitset.
+	// This also meanst that getting/retrieving values is going to be slower than std::bitset. If 
+	// you know at compile time what size the bitset is going to be, it is highly recommended to 
+	// use std::bitset. If you don't need to store/retrieve triviably copyable types in binary 
+	// format, it is highly recommned to use std::vector<bool>.
+	//
+	// The first bit is the most significant bit of the first block, so the bit order within each
+	// byte is the same as byte::get/byte::set, no matter the type of block. The bytes that are
+	// pushed back and extracted are therefore identical for every Block; wider blocks only mean
+	// that the bits are allocated and processed a word at a time instead of a char at a time.
+	template<typename Block = std::uint64_t, typename Container = std::vector<Block>>
+	class basic_dynamic_bitset
+	{
+		static_assert(std::is_unsigned<Block>::value && !std::is_same<Block, bool>::value, "Blocks must be unsigned integers");
+		static_assert(std::is_same<typename Container::value_type, Block>::value, "The container must store blocks");
+
+		static constexpr size_t sNumOfBitsInBlock = sNumOfBitsInType<Block>;
+
 	public:
+		using block_type = Block;
+		using container_type = Container;
+		using allocator_type = typename detail::AllocatorOf<Container>::type;
+		using bit_reference = basic_bit_ref<Block>;
+
 		class iterator :
-			public IteratorBase<iterator>
+			public detail::IteratorBase<iterator>
 		{
 		public:
-			iterator() = default;
-			iterator(dynamic_bitset* source, byte_index byteIndex, bit_index bitIndex) : IteratorBase(byteIndex, bitIndex), mSource(source) {}
+			constexpr iterator() = default;
+			constexpr iterator(basic_dynamic_bitset* source, byte_index byteIndex, bit_index bitIndex) : detail::IteratorBase<iterator>(byteIndex, bitIndex), mSource(source) {}
 
-			using pointer = bit_ref;
-			using reference = bit_ref;
+			using pointer = bit_reference;
+			using reference = bit_reference;
 
-			reference operator*() const
+			constexpr reference operator*() const
 			{
 #if _ITERATOR_DEBUG_LEVEL > 0
 				assert(mSource != nullptr);
 #endif // _ITERATOR_DEBUG_LEVEL > 0
-				return mSource->getBitRef(mByteIndex, mBitIndex);
+				return mSource->getBitRef(this->mByteIndex, this->mBitIndex);
 			}
-			pointer operator->() const
+			constexpr pointer operator->() const
 			{
 				return *(*this);
 			}
 
 			// Prefer this over getting a const reference for performance reasons.
-			inline operator bit() const
+			constexpr operator bit() const
 			{
 #if _ITERATOR_DEBUG_LEVEL > 0
 				assert(mSource != nullptr);
 #endif // _ITERATOR_DEBUG_LEVEL > 0
-				return mSource->get(mByteIndex, mBitIndex);
+				return mSource->get(this->mByteIndex, this->mBitIndex);
 			}
 
 		private:
-			friend dynamic_bitset;
-			dynamic_bitset* mSource{};
+			friend basic_dynamic_bitset;
+			basic_dynamic_bitset* mSource{};
 		};
 
 		class const_iterator :
-			public IteratorBase<const_iterator>
+			public detail::IteratorBase<const_iterator>
 		{
 		public:
-			const_iterator() = default;
-			const_iterator(const dynamic_bitset* source, byte_index byteIndex, bit_index bitIndex) : IteratorBase(byteIndex, bitIndex), mSource(source) {}
+			constexpr const_iterator() = default;
+			constexpr const_iterator(const basic_dynamic_bitset* source, byte_index byteIndex, bit_index bitIndex) : detail::IteratorBase<const_iterator>(byteIndex, bitIndex), mSource(source) {}
 
 			using pointer = bit;
 			using reference = bit; 
 
-			reference operator*() const
+			constexpr reference operator*() const
 			{ 
 #if _ITERATOR_DEBUG_LEVEL > 0
 				assert(mSource != nullptr);
 #endif // _ITERATOR_DEBUG_LEVEL > 0
-				return mSource->get(mByteIndex, mBitIndex);
+				return mSource->get(this->mByteIndex, this->mBitIndex);
 			}
-			pointer operator->() const 
+			constexpr pointer operator->() const 
 			{ 
 				return *(*this);
 			}
 
-			inline operator bit() const
+			constexpr operator bit() const
 			{
 #if _ITERATOR_DEBUG_LEVEL > 0
 				assert(mSource != nullptr);
 #endif // _ITERATOR_DEBUG_LEVEL > 0
-				return mSource->get(mByteIndex, mBitIndex);
+				return mSource->get(this->mByteIndex, this->mBitIndex);
 			}
 
 		private:
-			friend dynamic_bitset;
-			const dynamic_bitset* mSource{};
+			friend basic_dynamic_bitset;
+			const basic_dynamic_bitset* mSource{};
 		};
 
-		inline iterator begin()
+		constexpr basic_dynamic_bitset() = default;
+		constexpr basic_dynamic_bitset(const basic_dynamic_bitset& other) = default;
+
+		// A moved-from bitset is empty, so its size always matches its blocks.
+		constexpr basic_dynamic_bitset(basic_dynamic_bitset&& other) noexcept :
+			mData(std::move(other.mData)),
+			mNumOfBits(std::exchange(other.mNumOfBits, 0))
+		{
+			other.mData.clear();
+		}
+
+		constexpr basic_dynamic_bitset& operator=(const basic_dynamic_bitset& other) = default;
+
+		constexpr basic_dynamic_bitset& operator=(basic_dynamic_bitset&& other) noexcept(std::is_nothrow_move_assignable<Container>::value)
+		{
+			if (this != &other)
+			{
+				mData = std::move(other.mData);
+				mNumOfBits = std::exchange(other.mNumOfBits, 0);
+				other.mData.clear();
+			}
+			return *this;
+		}
+
+		constexpr explicit basic_dynamic_bitset(const allocator_type& allocator) requires detail::AllocatorAware<Container> :
+			mData(allocator)
+		{}
+
+		// The allocator-extended copy and move make containers of bitsets (e.g. a std::pmr::vector of
+		// pmr::dynamic_bitset) hand their allocator down to the bitsets inside them.
+		constexpr basic_dynamic_bitset(const basic_dynamic_bitset& other, const allocator_type& allocator) requires detail::AllocatorAware<Container> :
+			mData(other.mData, allocator),
+			mNumOfBits(other.mNumOfBits)
+		{}
+
+		constexpr basic_dynamic_bitset(basic_dynamic_bitset&& other, const allocator_type& allocator) requires detail::AllocatorAware<Container> :
+			mData(std::move(other.mData), allocator),
+			mNumOfBits(other.mNumOfBits)
+		{
+			other.clear();
+		}
+
+		constexpr allocator_type get_allocator() const requires detail::AllocatorAware<Container>
+		{
+			return mData.get_allocator();
+		}
+
+		constexpr iterator begin()
 		{
 			return begin<iterator>(this);
 		}
 
-		inline iterator end()
+		constexpr iterator end()
 		{
 			return end<iterator>(this);
 		};
 
-		inline const_iterator begin() const
+		constexpr const_iterator begin() const
 		{
 			return begin<const_iterator>(this);
 		}
 
-		inline const_iterator end() const
+		constexpr const_iterator end() const
 		{
 			return end<const_iterator>(this);
 		}
 
-		inline bit get(byte_index byteIndex, bit_index bitIndex) const
+		constexpr bit get(byte_index byteIndex, bit_index bitIndex) const
 		{
+			const size_t bitPosition = byteIndex * sNumOfBitsInByte + bitIndex;
+
 #if _ITERATOR_DEBUG_LEVEL > 0
-			assert(byteIndex < mData.size()
-				|| (byteIndex == mData.size() && bitIndex < mIncompleteByte.mNumOfBits));
+			assert(bitPosition < mNumOfBits);
 #endif // _ITERATOR_DEBUG_LEVEL
 
-			const byte& byte = byteIndex < mData.size() ? mData[byteIndex] : mIncompleteByte.mByte;
-			return byte.get(bitIndex);
+			return detail::getBit(mData.data(), bitPosition);
 		}
 
 		// Returns the bit the iterator is pointing too and increments the iterator
-		inline bit get(iterator& it) const
+		constexpr bit get(iterator& it) const
 		{
 			bit returnBit = it;
 			++it;
 			return returnBit;
 		}
 
-		inline bit_ref getBitRef(byte_index byteIndex, bit_index bitIndex)
+		constexpr bit_reference getBitRef(byte_index byteIndex, bit_index bitIndex)
 		{
+			const size_t bitPosition = byteIndex * sNumOfBitsInByte + bitIndex;
+
 #if _ITERATOR_DEBUG_LEVEL > 0
-			assert(byteIndex < mData.size()
-				|| (byteIndex == mData.size() && bitIndex < mIncompleteByte.mNumOfBits));
+			assert(bitPosition < mNumOfBits);
 #endif // _ITERATOR_DEBUG_LEVEL
 
-			byte& returnByte = byteIndex < mData.size() ? mData[byteIndex] : mIncompleteByte.mByte;
-			return returnByte.getBitRef(bitIndex);
+			return { mData[bitPosition / sNumOfBitsInBlock], static_cast<bit_index>(bitPosition % sNumOfBitsInBlock) };
 		}
 
 		// Returns the bitref the iterator is pointing too and increments the iterator
-		inline bit_ref getBitRef(iterator& it)
+		constexpr bit_reference getBitRef(iterator& it)
 		{
-			bit_ref returnBitref = *it;
+			bit_reference returnBitref = *it;
 			++it;
 			return returnBitref;
 		}
 
 		template<typename TriviablyCopyableType>
-		inline void push_back(const TriviablyCopyableType& value)
+		constexpr void push_back(const TriviablyCopyableType& value)
 		{
 			static_assert(std::is_trivially_copyable<TriviablyCopyableType>::value);
 
-			const byte* data = reinterpret_cast<const byte*>(&value);
-			const size_t size = sizeof(value);
-
-			for (size_t i = 0; i < size; i++)
+			if (std::is_constant_evaluated())
 			{
-				push_back(data[i]);
+				const auto bytes = std::bit_cast<std::array<unsigned char, sizeof(value)>>(value);
+				const size_t bitIndex = mNumOfBits;
+				growTo(mNumOfBits + sizeof(value) * sNumOfBitsInByte);
+				detail::orBytes(mData.data(), bitIndex, bytes.data(), bytes.size());
+				return;
 			}
+
+			push_back(reinterpret_cast<const char*>(&value), sizeof(value));
 		}
 
-		inline void push_back(byte byte)
+		// Appends the bytes in a single pass, regardless of whether the bitset currently ends halfway a byte.
+		constexpr void push_back(const char* source, size_t amountOfBytesToPushBack)
 		{
-			for (bit_index i = 0; i < sNumOfBitsInByte; i++)
+			if (amountOfBytesToPushBack == 0)
+			{
+				return;
+			}
+
+			const size_t bitIndex = mNumOfBits;
+			growTo(mNumOfBits + amountOfBytesToPushBack * sNumOfBitsInByte);
+
+			if (std::is_constant_evaluated())
 			{
-				push_back(byte.get(i));
+				for (size_t i = 0; i < amountOfBytesToPushBack; i++)
+				{
+					detail::orBits(mData.data(), bitIndex + i * sNumOfBitsInByte, static_cast<unsigned char>(source[i]), sNumOfBitsInByte);
+				}
+				return;
 			}
+
+			detail::orBytes(mData.data(), bitIndex, reinterpret_cast<const unsigned char*>(source), amountOfBytesToPushBack);
 		}
 
-		inline void push_back(bit bit)
+		constexpr void push_back(byte byte)
 		{
-			mIncompleteByte.mByte.set(mIncompleteByte.mNumOfBits, bit);
-			mIncompleteByte.mNumOfBits++;
+			const size_t bitIndex = mNumOfBits;
+			growTo(mNumOfBits + sNumOfBitsInByte);
+			detail::orBits(mData.data(), bitIndex, static_cast<unsigned char>(byte), sNumOfBitsInByte);
+		}
 
-			if (mIncompleteByte.isFull())
+		constexpr void push_back(bit bit)
+		{
+			// Every block is in use up to the last bit, so a new one is needed whenever the last one is full.
+			if (mNumOfBits % sNumOfBitsInBlock == 0)
 			{
-				mData.push_back(mIncompleteByte.mByte);
-				mIncompleteByte.mNumOfBits = 0;
+				mData.resize(mNumOfBits / sNumOfBitsInBlock + 1);
 			}
+
+			detail::setBit(mData.data(), mNumOfBits, bit);
+			mNumOfBits++;
 		}
 
-		// Removes the last bit.
-		inline void pop_back()
+		// Appends the numOfBits (0 to 64) least significant bits of the value, most significant bit first,
+		// matching the order of byte::set. Useful for packing fields that are not a whole number of bytes.
+		constexpr void write_bits(std::uint64_t value, unsigned numOfBits)
 		{
-			if (isThereAnIncompleteByte())
+			assert(numOfBits <= detail::sNumOfBitsInWord);
+
+			if (numOfBits == 0)
 			{
-				mIncompleteByte.mNumOfBits--;
 				return;
 			}
 
-			assert(!mData.empty());
+			const size_t bitIndex = mNumOfBits;
+			growTo(mNumOfBits + numOfBits);
+			detail::orBits(mData.data(), bitIndex, value & detail::getLowMask(numOfBits), numOfBits);
+		}
+
+		// Removes the last bit.
+		constexpr void pop_back()
+		{
+			assert(mNumOfBits > 0);
+
+			mNumOfBits--;
 
-			mIncompleteByte.mByte = mData.back();
-			mIncompleteByte.mNumOfBits = sNumOfBitsInByte - 1;
+			// The bits past the end are always kept at zero.
+			detail::setBit(mData.data(), mNumOfBits, false);
 
-			mData.pop_back();
+			if (mNumOfBits == (mData.size() - 1) * sNumOfBitsInBlock)
+			{
+				mData.resize(mData.size() - 1);
+			}
 		}
 
-		inline void clear()
+		constexpr void clear()
 		{
 			mData.clear();
-			mIncompleteByte.mNumOfBits = 0;
+			mNumOfBits = 0;
+		}
+
+		// Changes the number of bits. New bits are set to value, a whole block at a time.
+		constexpr void resize(size_t numOfBits, bit value = false)
+		{
+			const size_t oldNumOfBits = mNumOfBits;
+			const size_t numOfBitsInFirstBlock = oldNumOfBits % sNumOfBitsInBlock;
+
+			// The new blocks are filled while resizing rather than zeroed and then set. Resizing comes first, so
+			// that if it throws the bits past the end are still zero.
+			mData.resize(detail::getNumOfBlocksNeeded<Block>(numOfBits), value ? static_cast<Block>(~Block{}) : Block{});
+
+			if (value && numOfBits > oldNumOfBits && numOfBitsInFirstBlock != 0)
+			{
+				mData[oldNumOfBits / sNumOfBitsInBlock] |= static_cast<Block>(static_cast<Block>(~Block{}) >> numOfBitsInFirstBlock);
+			}
+			mNumOfBits = numOfBits;
+			clearBitsPastEnd();
+		}
+
+		// Allocates room for at least numOfBits bits, so that appending up to that size doesn't reallocate.
+		constexpr void reserve(size_t numOfBits)
+		{
+			mData.reserve(detail::getNumOfBlocksNeeded<Block>(numOfBits));
+		}
+
+		// Returns the number of bits that fit without reallocating.
+		constexpr size_t capacity() const
+		{
+			return mData.capacity() * sNumOfBitsInBlock;
+		}
+
+		constexpr void shrink_to_fit()
+		{
+			mData.shrink_to_fit();
 		}
 
 		// Creates and returns an instance of the type by using the next sizeof(type) bytes.
 		template <typename TriviablyCopyableType>
-		inline TriviablyCopyableType extract(byte_index byteIndex, bit_index bitIndex)
+		constexpr TriviablyCopyableType extract(byte_index byteIndex, bit_index bitIndex)
 		{
 			iterator it = { this, byteIndex, bitIndex };
 			return extract<TriviablyCopyableType>(it);
@@ -363,93 +1182,353 @@ namespace DB
 
 		// Creates and returns an instance of the type by using the next sizeof(type) bytes. Increments the iterator by the size of the type.
 		template <typename TriviablyCopyableType>
-		static inline TriviablyCopyableType extract(iterator& it)
+		static constexpr TriviablyCopyableType extract(iterator& it)
 		{
 			static_assert(std::is_trivially_copyable<TriviablyCopyableType>::value);
 
 			constexpr size_t numOfBytes = sizeof(TriviablyCopyableType);
+
+			if (std::is_constant_evaluated())
+			{
+				std::array<char, numOfBytes> bytes{};
+				extract(bytes.data(), numOfBytes, it);
+				return std::bit_cast<TriviablyCopyableType>(bytes);
+			}
+
 			TriviablyCopyableType returnValue{};
-			byte* asByte = reinterpret_cast<byte*>(&returnValue);
 			extract(reinterpret_cast<char*>(&returnValue), numOfBytes, it);
 
 			return returnValue;
 		}
 
 		// Fills the destination with the bytes specified using the byteIndex and bitIndex
-		inline void extract(char* destination, size_t amountOfBytesToExtract, byte_index byteIndex, bit_index bitIndex)
+		constexpr void extract(char* destination, size_t amountOfBytesToExtract, byte_index byteIndex, bit_index bitIndex)
 		{
 			iterator it = { this, byteIndex, bitIndex };
 			extract(destination, amountOfBytesToExtract, it);
 		}
 
 		// Fills the destination with the bytes the iterator is pointing too and increments the iterator
-		static inline void extract(char* destination, size_t amountOfBytesToExtract, iterator& it)
+		static constexpr void extract(char* destination, size_t amountOfBytesToExtract, iterator& it)
 		{
-			for (size_t i = 0; i < amountOfBytesToExtract; i++)
+			const basic_dynamic_bitset& source = *it.mSource;
+			const size_t bitIndex = it.getBitIndex();
+
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitIndex + amountOfBytesToExtract * sNumOfBitsInByte <= source.mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			if (std::is_constant_evaluated())
+			{
+				for (size_t i = 0; i < amountOfBytesToExtract; i++)
+				{
+					destination[i] = static_cast<char>(detail::readBits(source.mData.data(), bitIndex + i * sNumOfBitsInByte, sNumOfBitsInByte));
+				}
+			}
+			else
 			{
-				destination[i] = getByte(it);
+				detail::readBytes(source.mData.data(), source.mData.size(), bitIndex, reinterpret_cast<unsigned char*>(destination), amountOfBytesToExtract);
 			}
+			it.mByteIndex += amountOfBytesToExtract;
 		}
 
-		bool isThereAnIncompleteByte() const 
+		// Returns the next numOfBits (0 to 64) bits in the least significant bits of the return value, the bit
+		// the iterator is pointing to being the most significant of those. Increments the iterator by numOfBits.
+		static constexpr std::uint64_t read_bits(iterator& it, unsigned numOfBits)
+		{
+			assert(numOfBits <= detail::sNumOfBitsInWord);
+
+			if (numOfBits == 0)
+			{
+				return 0;
+			}
+
+			const size_t bitIndex = it.getBitIndex();
+
+#if _ITERATOR_DEBUG_LEVEL > 0
+			assert(bitIndex + numOfBits <= it.mSource->mNumOfBits);
+#endif // _ITERATOR_DEBUG_LEVEL
+
+			const std::uint64_t value = detail::readBits(it.mSource->mData.data(), bitIndex, numOfBits);
+			it += numOfBits;
+			return value;
+		}
+
+		// The bitwise operators keep the size of the left hand side. When the right hand side is shorter, its
+		// missing bits are treated as zero, when it's longer its additional bits are ignored.
+		constexpr basic_dynamic_bitset& operator&=(const basic_dynamic_bitset& other)
+		{
+			combine<detail::BitwiseOperation::And>(other);
+
+			// Anything past the end of the other bitset is ANDed with zero.
+			for (size_t i = other.mData.size(); i < mData.size(); i++)
+			{
+				mData[i] = 0;
+			}
+			return *this;
+		}
+
+		constexpr basic_dynamic_bitset& operator|=(const basic_dynamic_bitset& other)
+		{
+			combine<detail::BitwiseOperation::Or>(other);
+			return *this;
+		}
+
+		constexpr basic_dynamic_bitset& operator^=(const basic_dynamic_bitset& other)
+		{
+			combine<detail::BitwiseOperation::Xor>(other);
+			return *this;
+		}
+
+		// Clears every bit that is set in the other bitset, i.e. *this &= ~other.
+		constexpr basic_dynamic_bitset& andnot(const basic_dynamic_bitset& other)
+		{
+			combine<detail::BitwiseOperation::AndNot>(other);
+			return *this;
+		}
+
+		// Inverts every bit.
+		constexpr basic_dynamic_bitset& flip()
+		{
+			Block* const blocks = mData.data();
+			for (size_t i = 0; i < mData.size(); i++)
+			{
+				blocks[i] = static_cast<Block>(~blocks[i]);
+			}
+			clearBitsPastEnd();
+			return *this;
+		}
+
+		friend constexpr basic_dynamic_bitset operator&(basic_dynamic_bitset lhs, const basic_dynamic_bitset& rhs)
+		{
+			return lhs &= rhs;
+		}
+
+		friend constexpr basic_dynamic_bitset operator|(basic_dynamic_bitset lhs, const basic_dynamic_bitset& rhs)
+		{
+			return lhs |= rhs;
+		}
+
+		friend constexpr basic_dynamic_bitset operator^(basic_dynamic_bitset lhs, const basic_dynamic_bitset& rhs)
+		{
+			return lhs ^= rhs;
+		}
+
+		friend constexpr basic_dynamic_bitset andnot(basic_dynamic_bitset lhs, const basic_dynamic_bitset& rhs)
+		{
+			return lhs.andnot(rhs);
+		}
+
+		friend constexpr basic_dynamic_bitset operator~(basic_dynamic_bitset bitset)
+		{
+			return bitset.flip();
+		}
+
+		// Returned by the find functions when there is no such bit.
+		static constexpr size_t npos = detail::sNotFound;
+
+		// Returns the index of the first set bit, or npos if no bits are set.
+		constexpr size_t find_first() const
+		{
+			return detail::findNext<true>(mData.data(), mNumOfBits, 0);
+		}
+
+		// Returns the index of the first set bit after bitIndex, or npos if there is none.
+		constexpr size_t find_next(size_t bitIndex) const
+		{
+			return bitIndex == npos ? npos : detail::findNext<true>(mData.data(), mNumOfBits, bitIndex + 1);
+		}
+
+		// Returns the index of the last set bit before bitIndex, or npos if there is none.
+		constexpr size_t find_prev(size_t bitIndex) const
+		{
+			return detail::findPreviousSetBit(mData.data(), bitIndex < mNumOfBits ? bitIndex : mNumOfBits);
+		}
+
+		// Returns the index of the first unset bit, or npos if all bits are set.
+		constexpr size_t find_first_zero() const
+		{
+			return detail::findNext<false>(mData.data(), mNumOfBits, 0);
+		}
+
+		// Returns the index of the first unset bit after bitIndex, or npos if there is none.
+		constexpr size_t find_next_zero(size_t bitIndex) const
+		{
+			return bitIndex == npos ? npos : detail::findNext<false>(mData.data(), mNumOfBits, bitIndex + 1);
+		}
+
+		// Calls the callback with the index of every set bit, in order. Blocks without any set bits
+		// are skipped in a tight loop, so sparse bitsets are visited at the speed of a memory scan.
+		template<typename Callback>
+		constexpr void for_each_set_bit(Callback&& callback) const
+		{
+			const Block* const blocks = mData.data();
+			const size_t numOfBlocks = mData.size();
+
+			for (size_t blockIndex = 0;; blockIndex++)
+			{
+				blockIndex = detail::skipEmptyBlocks(blocks, numOfBlocks, blockIndex);
+
+				if (blockIndex == numOfBlocks)
+				{
+					return;
+				}
+
+				Block value = blocks[blockIndex];
+
+				do
+				{
+					const size_t bitIndexInBlock = std::countl_zero(value);
+					value = static_cast<Block>(value ^ (Block{ 1 } << (sNumOfBitsInBlock - 1 - bitIndexInBlock)));
+					callback(blockIndex * sNumOfBitsInBlock + bitIndexInBlock);
+				} while (value != 0);
+			}
+		}
+
+		// Returns the number of set bits.
+		constexpr size_t count() const
+		{
+			return detail::countBits(mData.data(), 0, mNumOfBits);
+		}
+
+		// Returns the number of set bits from first up to, but not including, last.
+		constexpr size_t count(const_iterator first, const_iterator last) const
+		{
+			return countRange(first.getBitIndex(), last.getBitIndex());
+		}
+
+		constexpr size_t count(iterator first, iterator last) const
+		{
+			return countRange(first.getBitIndex(), last.getBitIndex());
+		}
+
+		// Returns the number of set bits before the bit at bitIndex. bitIndex may be equal to the number of bits.
+		constexpr size_t rank(size_t bitIndex) const
+		{
+			return countRange(0, bitIndex);
+		}
+
+		constexpr bool isThereAnIncompleteByte() const 
 		{ 
-			return mIncompleteByte.mNumOfBits > 0;
+			return mNumOfBits % sNumOfBitsInByte != 0;
+		}
+
+		// Returns the number of bits.
+		constexpr size_t size() const
+		{
+			return mNumOfBits;
+		}
+
+		// Returns the number of bytes the bits take up, counting an incomplete last byte as a whole byte.
+		constexpr size_t size_in_bytes() const
+		{
+			return detail::getNumOfBlocksNeeded<unsigned char>(mNumOfBits);
+		}
+
+		constexpr bool empty() const
+		{
+			return mNumOfBits == 0;
+		}
+
+		// Returns the number of blocks that data() points to.
+		constexpr size_t num_words() const
+		{
+			return mData.size();
+		}
+
+		// The blocks holding the bits, the first bit being the most significant bit of the first block.
+		// The bits past the last bit are zero.
+		constexpr const Block* data() const
+		{
+			return mData.data();
+		}
+
+		// Allows filling the blocks directly, e.g. from a file. The bits past the last bit must stay zero.
+		constexpr Block* data()
+		{
+			return mData.data();
 		}
 
 	private:
-		// Returns the byte the iterator is pointing too and increments the iterator
-		static byte getByte(iterator& iterator)
+		// Increases the number of bits, the new bits are zero.
+		constexpr void growTo(size_t numOfBits)
+		{
+			mData.resize(detail::getNumOfBlocksNeeded<Block>(numOfBits));
+			mNumOfBits = numOfBits;
+		}
+
+		constexpr size_t countRange(size_t firstBitIndex, size_t lastBitIndex) const
 		{
-			// This is much faster, it's worth it for us to check to see if this is a possibility.
-			if (iterator.mBitIndex == 0)
-			{
 #if _ITERATOR_DEBUG_LEVEL > 0
-				assert(iterator.mByteIndex < iterator.mSource->mData.size());
+			assert(firstBitIndex <= lastBitIndex && lastBitIndex <= mNumOfBits);
 #endif // _ITERATOR_DEBUG_LEVEL
-				return iterator.mSource->mData[iterator.mByteIndex];
-			}
 
-			byte returnByte{};
-			for (bit_index i = 0; i < sNumOfBitsInByte; i++, ++iterator)
+			return detail::countBits(mData.data(), firstBitIndex, lastBitIndex);
+		}
+
+		template<detail::BitwiseOperation Operation>
+		constexpr void combine(const basic_dynamic_bitset& other)
+		{
+			const size_t numOfBlocks = mData.size() < other.mData.size() ? mData.size() : other.mData.size();
+
+			if (std::is_constant_evaluated())
+			{
+				for (size_t i = 0; i < numOfBlocks; i++)
+				{
+					mData[i] = detail::combine<Operation>(mData[i], other.mData[i]);
+				}
+			}
+			else
 			{
-				bit bit = iterator.mSource->get(iterator.mByteIndex, iterator.mBitIndex);
-				returnByte.set(i, bit);
+				detail::combineBytes<Operation>(reinterpret_cast<unsigned char*>(mData.data()), reinterpret_cast<const unsigned char*>(other.mData.data()), numOfBlocks * sizeof(Block));
 			}
 
-			return returnByte;
+			// The other bitset may be longer, in which case bits past our end may have been set.
+			clearBitsPastEnd();
+		}
+
+		constexpr void clearBitsPastEnd()
+		{
+			const size_t numOfBitsInLastBlock = mNumOfBits % sNumOfBitsInBlock;
+
+			if (numOfBitsInLastBlock != 0)
+			{
+				mData.data()[mNumOfBits / sNumOfBitsInBlock] &= static_cast<Block>(static_cast<Block>(~Block{}) << (sNumOfBitsInBlock - numOfBitsInLastBlock));
+			}
 		}
 
 		template<typename IteratorType, typename From>
-		static IteratorType begin(From* fromBitset)
+		static constexpr IteratorType begin(From* fromBitset)
 		{
 			return IteratorType{ fromBitset, 0, 0 };
 		}
 
 		template<typename IteratorType, typename From>
-		static IteratorType end(From* fromBitset)
+		static constexpr IteratorType end(From* fromBitset)
 		{
-			byte_index byteIndex = fromBitset->mData.size();
-			bit_index bitIndex = 0;
-
-			if (fromBitset->isThereAnIncompleteByte())
-			{
-				bitIndex = fromBitset->mIncompleteByte.mNumOfBits;
-			}
+			const byte_index byteIndex = fromBitset->mNumOfBits / sNumOfBitsInByte;
+			const bit_index bitIndex = fromBitset->mNumOfBits % sNumOfBitsInByte;
 
 			return IteratorType{ fromBitset, byteIndex, bitIndex };
 		}
 
-		std::vector<byte> mData{};
+		// Every block up to and including the one holding the last bit. The bits past the
+		// last bit are always zero.
+		Container mData{};
+		size_t mNumOfBits{};
+	};
 
-		struct IncompleteByte
-		{
-			byte mByte{};
-			bit_index mNumOfBits = 0;
+	using dynamic_bitset = basic_dynamic_bitset<>;
 
-			bool isFull() const { return mNumOfBits == sNumOfBitsInByte; }
-		};
-		IncompleteByte mIncompleteByte{};
+	// A reference to a bit of a dynamic_bitset, as returned by its getBitRef and iterators.
+	using bit_ref = dynamic_bitset::bit_reference;
 
-		bit_index mBitIndex = sNumOfBitsInByte - 1;
-	};
+	namespace pmr
+	{
+		// Bitsets whose blocks come from a std::pmr::memory_resource, e.g. a monotonic arena.
+		template<typename Block = std::uint64_t>
+		using basic_dynamic_bitset = DB::basic_dynamic_bitset<Block, std::pmr::vector<Block>>;
+
+		using dynamic_bitset = basic_dynamic_bitset<>;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,592 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	namespace detail
+	{
+		// An EWAH marker word holds, from least to most significant bit, the fill bit, the number of fill
+		// words (32 bits) and the number of literal words that follow the marker (31 bits).
+		constexpr std::uint64_t sEwahMaxNumOfFillWords = 0xFFFFFFFF;
+		constexpr std::uint64_t sEwahMaxNumOfLiteralWords = 0x7FFFFFFF;
+
+		constexpr bit getEwahFillBit(std::uint64_t marker)
+		{
+			return marker & 1;
+		}
+
+		constexpr std::uint64_t getEwahNumOfFillWords(std::uint64_t marker)
+		{
+			return (marker >> 1) & sEwahMaxNumOfFillWords;
+		}
+
+		constexpr std::uint64_t getEwahNumOfLiteralWords(std::uint64_t marker)
+		{
+			return marker >> 33;
+		}
+
+		constexpr std::uint64_t makeEwahMarker(bit fillBit, std::uint64_t numOfFillWords, std::uint64_t numOfLiteralWords)
+		{
+			return static_cast<std::uint64_t>(fillBit) | numOfFillWords << 1 | numOfLiteralWords << 33;
+		}
+
+		// Walks the uncompressed words of an ewah_bitset as segments of either fill words or literal words,
+		// followed by the incomplete last word if there is one. Once done, it acts as an endless fill of
+		// zeros, so bitsets of different lengths can be combined.
+		class EwahCursor
+		{
+		public:
+			EwahCursor() = default;
+
+			EwahCursor(const std::uint64_t* words, size_t numOfWords, const std::uint64_t* lastWord) :
+				mWords(words),
+				mNumOfWords(numOfWords),
+				mLastWord(lastWord),
+				mIsDone(false)
+			{
+				nextSegment();
+			}
+
+			bool done() const
+			{
+				return mIsDone;
+			}
+
+			bool isFill() const
+			{
+				return mNumOfFillWords > 0 || mIsDone;
+			}
+
+			bit fillBit() const
+			{
+				return mFillBit;
+			}
+
+			// Whether the current segment is the incomplete last word.
+			bool isLastWord() const
+			{
+				return mIsLastWord;
+			}
+
+			// The number of words left in the current segment.
+			size_t available() const
+			{
+				if (mIsDone)
+				{
+					return std::numeric_limits<size_t>::max();
+				}
+				return static_cast<size_t>(isFill() ? mNumOfFillWords : mNumOfLiteralWords);
+			}
+
+			std::uint64_t literal(size_t index) const
+			{
+				return mLiterals[index];
+			}
+
+			const std::uint64_t* literals() const
+			{
+				return mLiterals;
+			}
+
+			// Skips numOfWords words, which must not be more than are available.
+			void advance(size_t numOfWords)
+			{
+				if (mIsDone)
+				{
+					return;
+				}
+
+				if (isFill())
+				{
+					mNumOfFillWords -= numOfWords;
+				}
+				else
+				{
+					mLiterals += numOfWords;
+					mNumOfLiteralWords -= numOfWords;
+				}
+
+				if (mNumOfFillWords == 0 && mNumOfLiteralWords == 0)
+				{
+					nextSegment();
+				}
+			}
+
+			std::uint64_t nextWord()
+			{
+				const std::uint64_t word = isFill() ? (mFillBit ? ~std::uint64_t{} : 0) : *mLiterals;
+				advance(1);
+				return word;
+			}
+
+		private:
+			void nextSegment()
+			{
+				while (mIndex < mNumOfWords)
+				{
+					const std::uint64_t marker = mWords[mIndex];
+					mFillBit = getEwahFillBit(marker);
+					mNumOfFillWords = getEwahNumOfFillWords(marker);
+					mNumOfLiteralWords = getEwahNumOfLiteralWords(marker);
+					mLiterals = mWords + mIndex + 1;
+					mIndex += 1 + mNumOfLiteralWords;
+
+					if (mNumOfFillWords > 0 || mNumOfLiteralWords > 0)
+					{
+						return;
+					}
+				}
+
+				if (mLastWord != nullptr && !mIsLastWord)
+				{
+					mNumOfFillWords = 0;
+					mNumOfLiteralWords = 1;
+					mLiterals = mLastWord;
+					mIsLastWord = true;
+					return;
+				}
+
+				mIsDone = true;
+				mIsLastWord = false;
+				mFillBit = false;
+				mNumOfFillWords = 0;
+				mNumOfLiteralWords = 0;
+			}
+
+			const std::uint64_t* mWords{};
+			size_t mNumOfWords{};
+			size_t mIndex{};
+			const std::uint64_t* mLastWord{};
+			const std::uint64_t* mLiterals{};
+			std::uint64_t mNumOfFillWords{};
+			std::uint64_t mNumOfLiteralWords{};
+			bit mFillBit{};
+			bool mIsLastWord{};
+			// A default constructed cursor has no words at all.
+			bool mIsDone = true;
+		};
+	}
+
+	// A compressed, append-only bitset for mostly uniform bits, e.g. flags that are nearly all zeros. Runs
+	// of 64 bit words that are all zeros or all ones are stored as a count, using the Enhanced Word-Aligned
+	// Hybrid (EWAH) encoding, while other words are stored as they are. A word holds the bits in the same
+	// order as a dynamic_bitset block, so converting between the two copies words.
+	//
+	// count(), for_each_set_bit() and the bitwise operators work on the compressed words directly,
+	// handling a run of any length in constant time.
+	class ewah_bitset
+	{
+	public:
+		using word = std::uint64_t;
+
+		// Iterates over the bits, in a single pass. Appending to the bitset invalidates its iterators.
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = bit;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = bit;
+
+			const_iterator() = default;
+
+			bit operator*() const
+			{
+				return (mWord >> (sNumOfBitsInWord - 1 - mBitIndex % sNumOfBitsInWord)) & 1;
+			}
+
+			const_iterator& operator++()
+			{
+				mBitIndex++;
+				if (mBitIndex % sNumOfBitsInWord == 0)
+				{
+					mWord = mCursor.nextWord();
+				}
+				return *this;
+			}
+
+			const_iterator operator++(int)
+			{
+				const_iterator it = *this;
+				++*this;
+				return it;
+			}
+
+			// Iterators of the same bitset are equal when they point at the same bit.
+			friend bool operator==(const const_iterator& lhs, const const_iterator& rhs)
+			{
+				return lhs.mBitIndex == rhs.mBitIndex;
+			}
+
+		private:
+			friend class ewah_bitset;
+
+			const_iterator(detail::EwahCursor cursor, size_t bitIndex) :
+				mCursor(cursor),
+				mBitIndex(bitIndex)
+			{
+				mWord = mCursor.nextWord();
+			}
+
+			detail::EwahCursor mCursor{};
+			word mWord{};
+			size_t mBitIndex{};
+		};
+
+		using iterator = const_iterator;
+
+		ewah_bitset() = default;
+
+		// Compresses the blocks of the bitset.
+		template<typename Container>
+		explicit ewah_bitset(const basic_dynamic_bitset<word, Container>& bitset)
+		{
+			const size_t numOfFullWords = bitset.size() / sNumOfBitsInWord;
+			const word* const blocks = bitset.data();
+
+			for (size_t i = 0; i < numOfFullWords; i++)
+			{
+				appendWord(blocks[i]);
+			}
+
+			mLastWord = numOfFullWords < bitset.num_words() ? blocks[numOfFullWords] : 0;
+			mNumOfBits = bitset.size();
+		}
+
+		// Decompresses into a bitset with the same bits.
+		template<typename Container = std::vector<word>>
+		basic_dynamic_bitset<word, Container> to_dynamic_bitset() const
+		{
+			basic_dynamic_bitset<word, Container> bitset{};
+			bitset.resize(mNumOfBits);
+
+			word* blocks = bitset.data();
+			detail::EwahCursor cursor = getCursor();
+			for (; !cursor.done(); cursor.advance(cursor.available()))
+			{
+				if (cursor.isFill())
+				{
+					blocks = std::fill_n(blocks, cursor.available(), cursor.fillBit() ? ~word{} : 0);
+				}
+				else
+				{
+					blocks = std::copy_n(cursor.literals(), cursor.available(), blocks);
+				}
+			}
+			return bitset;
+		}
+
+		const_iterator begin() const
+		{
+			return { getCursor(), 0 };
+		}
+
+		const_iterator end() const
+		{
+			return { {}, mNumOfBits };
+		}
+
+		void push_back(bit bit)
+		{
+			mLastWord |= static_cast<word>(bit) << (sNumOfBitsInWord - 1 - mNumOfBits % sNumOfBitsInWord);
+			mNumOfBits++;
+
+			if (mNumOfBits % sNumOfBitsInWord == 0)
+			{
+				appendWord(std::exchange(mLastWord, 0));
+			}
+		}
+
+		void push_back(byte byte)
+		{
+			write_bits(static_cast<unsigned char>(byte), sNumOfBitsInByte);
+		}
+
+		// Appends the numOfBits (0 to 64) least significant bits of the value, most significant bit first,
+		// like dynamic_bitset::write_bits.
+		void write_bits(word value, unsigned numOfBits)
+		{
+			assert(numOfBits <= sNumOfBitsInWord);
+
+			if (numOfBits == 0)
+			{
+				return;
+			}
+
+			value &= detail::getLowMask(numOfBits);
+			const unsigned numOfFreeBits = static_cast<unsigned>(sNumOfBitsInWord - mNumOfBits % sNumOfBitsInWord);
+			mNumOfBits += numOfBits;
+
+			if (numOfBits < numOfFreeBits)
+			{
+				mLastWord |= value << (numOfFreeBits - numOfBits);
+				return;
+			}
+
+			// Fills the last word, and starts the next one with the rest of the bits.
+			const unsigned numOfRemainingBits = numOfBits - numOfFreeBits;
+			appendWord(mLastWord | value >> numOfRemainingBits);
+			mLastWord = numOfRemainingBits == 0 ? 0 : value << (sNumOfBitsInWord - numOfRemainingBits);
+		}
+
+		// Appends numOfBits bits that all have the value, in constant time for the whole words among them.
+		void push_back(bit value, size_t numOfBits)
+		{
+			// Completes the last word first.
+			while (numOfBits > 0 && mNumOfBits % sNumOfBitsInWord != 0)
+			{
+				push_back(value);
+				numOfBits--;
+			}
+
+			appendFill(value, numOfBits / sNumOfBitsInWord);
+			mNumOfBits += numOfBits / sNumOfBitsInWord * sNumOfBitsInWord;
+
+			for (size_t i = 0; i < numOfBits % sNumOfBitsInWord; i++)
+			{
+				push_back(value);
+			}
+		}
+
+		void clear()
+		{
+			mWords.assign(1, 0);
+			mLastMarkerIndex = 0;
+			mLastWord = 0;
+			mNumOfBits = 0;
+		}
+
+		size_t count() const
+		{
+			size_t numOfSetBits{};
+			for (detail::EwahCursor cursor = getCursor(); !cursor.done(); cursor.advance(cursor.available()))
+			{
+				if (cursor.isFill())
+				{
+					numOfSetBits += cursor.fillBit() ? cursor.available() * sNumOfBitsInWord : 0;
+					continue;
+				}
+
+				for (size_t i = 0; i < cursor.available(); i++)
+				{
+					numOfSetBits += std::popcount(cursor.literal(i));
+				}
+			}
+			return numOfSetBits;
+		}
+
+		// Calls the function with the index of every set bit, in increasing order. Runs of zeros are skipped
+		// in constant time.
+		template<typename Function>
+		void for_each_set_bit(Function&& function) const
+		{
+			size_t bitIndex{};
+			for (detail::EwahCursor cursor = getCursor(); !cursor.done(); cursor.advance(cursor.available()))
+			{
+				const size_t numOfWords = cursor.available();
+
+				if (cursor.isFill())
+				{
+					if (cursor.fillBit())
+					{
+						for (size_t i = 0; i < numOfWords * sNumOfBitsInWord; i++)
+						{
+							function(bitIndex + i);
+						}
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < numOfWords; i++)
+					{
+						for (word value = cursor.literal(i); value != 0; value &= ~(word{ 1 } << (sNumOfBitsInWord - 1 - std::countl_zero(value))))
+						{
+							function(bitIndex + i * sNumOfBitsInWord + std::countl_zero(value));
+						}
+					}
+				}
+				bitIndex += numOfWords * sNumOfBitsInWord;
+			}
+		}
+
+		// The bitwise operators keep the size of the left hand side, like those of dynamic_bitset. When the
+		// right hand side is shorter, its missing bits are treated as zero.
+		friend ewah_bitset operator&(const ewah_bitset& lhs, const ewah_bitset& rhs)
+		{
+			return combine(lhs, rhs, [](word a, word b) { return a & b; });
+		}
+
+		friend ewah_bitset operator|(const ewah_bitset& lhs, const ewah_bitset& rhs)
+		{
+			return combine(lhs, rhs, [](word a, word b) { return a | b; });
+		}
+
+		friend ewah_bitset operator^(const ewah_bitset& lhs, const ewah_bitset& rhs)
+		{
+			return combine(lhs, rhs, [](word a, word b) { return a ^ b; });
+		}
+
+		ewah_bitset& operator&=(const ewah_bitset& other)
+		{
+			return *this = *this & other;
+		}
+
+		ewah_bitset& operator|=(const ewah_bitset& other)
+		{
+			return *this = *this | other;
+		}
+
+		ewah_bitset& operator^=(const ewah_bitset& other)
+		{
+			return *this = *this ^ other;
+		}
+
+		size_t size() const
+		{
+			return mNumOfBits;
+		}
+
+		bool empty() const
+		{
+			return mNumOfBits == 0;
+		}
+
+		// Returns the number of compressed words, including the incomplete last word.
+		size_t num_words() const
+		{
+			return mWords.size() + 1;
+		}
+
+	private:
+		static constexpr size_t sNumOfBitsInWord = detail::sNumOfBitsInWord;
+
+		detail::EwahCursor getCursor() const
+		{
+			return { mWords.data(), mWords.size(), mNumOfBits % sNumOfBitsInWord != 0 ? &mLastWord : nullptr };
+		}
+
+		void appendWord(word value)
+		{
+			if (value == 0 || value == ~word{})
+			{
+				appendFill(value != 0, 1);
+				return;
+			}
+
+			const word marker = mWords[mLastMarkerIndex];
+			const word numOfLiteralWords = detail::getEwahNumOfLiteralWords(marker);
+
+			if (numOfLiteralWords == detail::sEwahMaxNumOfLiteralWords)
+			{
+				mLastMarkerIndex = mWords.size();
+				mWords.push_back(detail::makeEwahMarker(false, 0, 0));
+				appendWord(value);
+				return;
+			}
+
+			mWords[mLastMarkerIndex] = detail::makeEwahMarker(detail::getEwahFillBit(marker), detail::getEwahNumOfFillWords(marker), numOfLiteralWords + 1);
+			mWords.push_back(value);
+		}
+
+		// Appends numOfWords words that are all zeros or all ones, without changing the number of bits.
+		void appendFill(bit fillBit, size_t numOfWords)
+		{
+			while (numOfWords > 0)
+			{
+				const word marker = mWords[mLastMarkerIndex];
+				const word numOfFillWords = detail::getEwahNumOfFillWords(marker);
+
+				// A marker's fill comes before its literals, so only a marker without literals can be extended.
+				if (detail::getEwahNumOfLiteralWords(marker) == 0 && (numOfFillWords == 0 || detail::getEwahFillBit(marker) == fillBit) && numOfFillWords < detail::sEwahMaxNumOfFillWords)
+				{
+					const word numOfWordsToAdd = std::min<word>(numOfWords, detail::sEwahMaxNumOfFillWords - numOfFillWords);
+					mWords[mLastMarkerIndex] = detail::makeEwahMarker(fillBit, numOfFillWords + numOfWordsToAdd, 0);
+					numOfWords -= static_cast<size_t>(numOfWordsToAdd);
+				}
+				else
+				{
+					mLastMarkerIndex = mWords.size();
+					mWords.push_back(detail::makeEwahMarker(false, 0, 0));
+				}
+			}
+		}
+
+		// Walks both bitsets a segment at a time. Where both are fills, or where one is a fill that decides
+		// the result on its own (e.g. zeros for AND), the whole segment is combined at once.
+		template<typename Operation>
+		static ewah_bitset combine(const ewah_bitset& lhs, const ewah_bitset& rhs, Operation operation)
+		{
+			ewah_bitset result;
+			detail::EwahCursor left = lhs.getCursor();
+			detail::EwahCursor right = rhs.getCursor();
+
+			while (!left.done())
+			{
+				if (left.isLastWord())
+				{
+					const word rightWord = right.isFill() ? (right.fillBit() ? ~word{} : 0) : right.literal(0);
+					result.mLastWord = operation(left.literal(0), rightWord) & ~detail::getLowMask(sNumOfBitsInWord - lhs.mNumOfBits % sNumOfBitsInWord);
+					break;
+				}
+
+				const size_t numOfWords = std::min(left.available(), right.available());
+
+				if (left.isFill() && right.isFill())
+				{
+					const word value = operation(left.fillBit() ? ~word{} : 0, right.fillBit() ? ~word{} : 0);
+					result.appendFill(value != 0, numOfWords);
+				}
+				else if (left.isFill() || right.isFill())
+				{
+					const detail::EwahCursor& fill = left.isFill() ? left : right;
+					const detail::EwahCursor& literals = left.isFill() ? right : left;
+					const word fillWord = fill.fillBit() ? ~word{} : 0;
+					const auto apply = [&](word literal) { return left.isFill() ? operation(fillWord, literal) : operation(literal, fillWord); };
+
+					if (apply(0) == apply(~word{}))
+					{
+						result.appendFill(apply(0) != 0, numOfWords);
+					}
+					else
+					{
+						for (size_t i = 0; i < numOfWords; i++)
+						{
+							result.appendWord(apply(literals.literal(i)));
+						}
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < numOfWords; i++)
+					{
+						result.appendWord(operation(left.literal(i), right.literal(i)));
+					}
+				}
+
+				left.advance(numOfWords);
+				right.advance(numOfWords);
+			}
+
+			result.mNumOfBits = lhs.mNumOfBits;
+			return result;
+		}
+
+		// Marker words, each followed by its literal words. The incomplete last word is kept separately, so
+		// appending a bit only touches it.
+		std::vector<word> mWords{ detail::makeEwahMarker(false, 0, 0) };
+		size_t mLastMarkerIndex{};
+		word mLastWord{};
+		size_t mNumOfBits{};
+	};
+}
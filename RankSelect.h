@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	namespace detail
+	{
+		// Returns the index of the set bit that has numOfSetBitsBefore set bits before it, counting from
+		// the most significant bit. The word must have more than numOfSetBitsBefore bits set.
+		inline bit_index selectInWord(word value, size_t numOfSetBitsBefore)
+		{
+			const size_t numOfSetBits = std::popcount(value);
+
+#if _CONTAINER_DEBUG_LEVEL > 0
+			assert(numOfSetBitsBefore < numOfSetBits);
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+
+			// Counting from the least significant bit, it has this many set bits below it instead.
+			const size_t numOfSetBitsBelow = numOfSetBits - numOfSetBitsBefore - 1;
+
+#if defined(__BMI2__)
+			const word selected = _pdep_u64(word{ 1 } << numOfSetBitsBelow, value);
+#else
+			for (size_t i = 0; i < numOfSetBitsBelow; i++)
+			{
+				value &= value - 1;
+			}
+			const word selected = value & (~value + 1);
+#endif // __BMI2__
+
+			return static_cast<bit_index>(std::countl_zero(selected));
+		}
+	}
+
+	// Owns a bitset and answers rank and select queries on it in (near) constant time, using an index
+	// of about 4% of the size of the bitset. The layout follows poppy: every 2^32 bits store the
+	// number of set bits before them in a 64-bit counter, every 2048 bits store a 32-bit counter
+	// relative to that, plus the number of set bits in the first three of their four 512-bit blocks.
+	// For select, the super block of every 8192nd set (and unset) bit is sampled as a size_t, so any
+	// size of bitset works, and the super blocks between two samples are binary searched.
+	//
+	// The bitset can still be appended to or shrunk through this class, which invalidates the index.
+	// The index is rebuilt in a single pass over the bits on the next query. Because of this, queries
+	// are not safe to call from multiple threads unless the index is up to date, see rebuild_index.
+	template<typename Bitset = dynamic_bitset>
+	class rank_select_bitset
+	{
+		static constexpr size_t sNumOfBitsInBasicBlock = 512;
+		static constexpr size_t sNumOfBasicBlocksInSuperBlock = 4;
+		static constexpr size_t sNumOfBitsInSuperBlock = sNumOfBitsInBasicBlock * sNumOfBasicBlocksInSuperBlock;
+		static constexpr size_t sNumOfBitsInUpperBlock = size_t{ 1 } << 32;
+		static constexpr size_t sNumOfSuperBlocksInUpperBlock = sNumOfBitsInUpperBlock / sNumOfBitsInSuperBlock;
+		static constexpr size_t sNumOfBitsInBasicBlockCount = 10;
+		static constexpr size_t sSelectSampleRate = 8192;
+
+	public:
+		rank_select_bitset() = default;
+		explicit rank_select_bitset(Bitset bitset) : mBitset(std::move(bitset)) {}
+
+		inline const Bitset& bitset() const
+		{
+			return mBitset;
+		}
+
+		// Appends to the bitset, accepts anything the bitset's push_back accepts.
+		template<typename... Args>
+		inline void push_back(Args&&... args)
+		{
+			mBitset.push_back(std::forward<Args>(args)...);
+			mIsIndexUpToDate = false;
+		}
+
+		inline void write_bits(std::uint64_t value, unsigned numOfBits)
+		{
+			mBitset.write_bits(value, numOfBits);
+			mIsIndexUpToDate = false;
+		}
+
+		inline void pop_back()
+		{
+			mBitset.pop_back();
+			mIsIndexUpToDate = false;
+		}
+
+		inline void clear()
+		{
+			mBitset.clear();
+			mIsIndexUpToDate = false;
+		}
+
+		// Returns the number of set bits before the bit at bitIndex. bitIndex may be equal to the number of bits.
+		inline size_t rank1(size_t bitIndex) const
+		{
+			assert(bitIndex <= mBitset.size());
+			rebuild_index();
+
+			const size_t superBlockIndex = bitIndex / sNumOfBitsInSuperBlock;
+			const size_t basicBlockIndex = bitIndex % sNumOfBitsInSuperBlock / sNumOfBitsInBasicBlock;
+			const size_t basicBlockStart = bitIndex - bitIndex % sNumOfBitsInBasicBlock;
+
+			// The bitIndex may be right at the end, in which case the last entry is past the end of the bitset.
+			if (superBlockIndex == mSuperBlocks.size())
+			{
+				return mNumOfSetBits;
+			}
+
+			return getNumOfSetBitsBeforeSuperBlock(superBlockIndex)
+				+ getNumOfSetBitsInFirstBasicBlocks(mSuperBlocks[superBlockIndex], basicBlockIndex)
+				+ detail::countBits(mBitset.data(), basicBlockStart, bitIndex);
+		}
+
+		// Returns the number of unset bits before the bit at bitIndex. bitIndex may be equal to the number of bits.
+		inline size_t rank0(size_t bitIndex) const
+		{
+			return bitIndex - rank1(bitIndex);
+		}
+
+		// Returns the index of the set bit that has numOfSetBitsBefore set bits before it.
+		inline size_t select1(size_t numOfSetBitsBefore) const
+		{
+			rebuild_index();
+			assert(numOfSetBitsBefore < mNumOfSetBits);
+			return select<true>(numOfSetBitsBefore);
+		}
+
+		// Returns the index of the unset bit that has numOfUnsetBitsBefore unset bits before it.
+		inline size_t select0(size_t numOfUnsetBitsBefore) const
+		{
+			rebuild_index();
+			assert(numOfUnsetBitsBefore < mBitset.size() - mNumOfSetBits);
+			return select<false>(numOfUnsetBitsBefore);
+		}
+
+		// Rebuilds the index if the bitset has changed since it was last built, queries call this
+		// automatically. Call this first if queries will be made from multiple threads.
+		inline void rebuild_index() const
+		{
+			if (mIsIndexUpToDate)
+			{
+				return;
+			}
+
+			const size_t numOfBits = mBitset.size();
+			const size_t numOfSuperBlocks = (numOfBits + sNumOfBitsInSuperBlock - 1) / sNumOfBitsInSuperBlock;
+
+			mUpperBlocks.clear();
+			mSuperBlocks.clear();
+			mSelectSamples[0].clear();
+			mSelectSamples[1].clear();
+			mSuperBlocks.reserve(numOfSuperBlocks);
+
+			size_t numOfSetBits{};
+
+			for (size_t superBlockIndex = 0; superBlockIndex < numOfSuperBlocks; superBlockIndex++)
+			{
+				if (superBlockIndex % sNumOfSuperBlocksInUpperBlock == 0)
+				{
+					mUpperBlocks.push_back(numOfSetBits);
+				}
+
+				const size_t superBlockStart = superBlockIndex * sNumOfBitsInSuperBlock;
+				const size_t numOfSetBitsBefore = numOfSetBits;
+				const size_t numOfUnsetBitsBefore = superBlockStart - numOfSetBits;
+				std::uint64_t entry = static_cast<std::uint64_t>(numOfSetBits - mUpperBlocks.back()) << 32;
+
+				for (size_t basicBlockIndex = 0; basicBlockIndex < sNumOfBasicBlocksInSuperBlock; basicBlockIndex++)
+				{
+					const size_t basicBlockStart = superBlockStart + basicBlockIndex * sNumOfBitsInBasicBlock;
+					const size_t basicBlockEnd = std::min(basicBlockStart + sNumOfBitsInBasicBlock, numOfBits);
+					const size_t numOfSetBitsInBasicBlock = basicBlockStart < basicBlockEnd ? detail::countBits(mBitset.data(), basicBlockStart, basicBlockEnd) : 0;
+
+					if (basicBlockIndex + 1 < sNumOfBasicBlocksInSuperBlock)
+					{
+						entry |= static_cast<std::uint64_t>(numOfSetBitsInBasicBlock) << getBasicBlockCountShift(basicBlockIndex);
+					}
+					numOfSetBits += numOfSetBitsInBasicBlock;
+				}
+
+				mSuperBlocks.push_back(entry);
+
+				// Sample the super block for every multiple of the sample rate that falls within it.
+				const size_t numOfUnsetBits = std::min(superBlockStart + sNumOfBitsInSuperBlock, numOfBits) - numOfSetBits;
+				addSelectSamples(mSelectSamples[1], numOfSetBitsBefore, numOfSetBits, superBlockIndex);
+				addSelectSamples(mSelectSamples[0], numOfUnsetBitsBefore, numOfUnsetBits, superBlockIndex);
+			}
+
+			mNumOfSetBits = numOfSetBits;
+			mIsIndexUpToDate = true;
+		}
+
+	private:
+		static constexpr size_t getBasicBlockCountShift(size_t basicBlockIndex)
+		{
+			return 32 - sNumOfBitsInBasicBlockCount * (basicBlockIndex + 1);
+		}
+
+		static inline void addSelectSamples(std::vector<size_t>& samples, size_t countBefore, size_t countAfter, size_t superBlockIndex)
+		{
+			for (size_t sample = (countBefore + sSelectSampleRate - 1) / sSelectSampleRate * sSelectSampleRate; sample < countAfter; sample += sSelectSampleRate)
+			{
+				samples.push_back(superBlockIndex);
+			}
+		}
+
+		static inline size_t getNumOfSetBitsInFirstBasicBlocks(std::uint64_t entry, size_t numOfBasicBlocks)
+		{
+			size_t numOfSetBits{};
+			for (size_t i = 0; i < numOfBasicBlocks; i++)
+			{
+				numOfSetBits += (entry >> getBasicBlockCountShift(i)) & ((1 << sNumOfBitsInBasicBlockCount) - 1);
+			}
+			return numOfSetBits;
+		}
+
+		inline size_t getNumOfSetBitsBeforeSuperBlock(size_t superBlockIndex) const
+		{
+			return mUpperBlocks[superBlockIndex / sNumOfSuperBlocksInUpperBlock] + (mSuperBlocks[superBlockIndex] >> 32);
+		}
+
+		template<bool CountSetBits>
+		inline size_t getCountBeforeSuperBlock(size_t superBlockIndex) const
+		{
+			const size_t numOfSetBits = getNumOfSetBitsBeforeSuperBlock(superBlockIndex);
+			return CountSetBits ? numOfSetBits : superBlockIndex * sNumOfBitsInSuperBlock - numOfSetBits;
+		}
+
+		template<bool CountSetBits>
+		inline size_t select(size_t rank) const
+		{
+			// The super block is between the ones of the samples around the rank. On sparse bitsets those can be
+			// far apart, so binary search for the last super block with at most rank bits before it.
+			const std::vector<size_t>& samples = mSelectSamples[CountSetBits];
+			const size_t sampleIndex = rank / sSelectSampleRate;
+			size_t superBlockIndex = samples[sampleIndex];
+			size_t lastSuperBlockIndex = sampleIndex + 1 < samples.size() ? samples[sampleIndex + 1] : mSuperBlocks.size() - 1;
+
+			while (superBlockIndex < lastSuperBlockIndex)
+			{
+				const size_t middle = superBlockIndex + (lastSuperBlockIndex - superBlockIndex + 1) / 2;
+				if (getCountBeforeSuperBlock<CountSetBits>(middle) <= rank)
+				{
+					superBlockIndex = middle;
+				}
+				else
+				{
+					lastSuperBlockIndex = middle - 1;
+				}
+			}
+			rank -= getCountBeforeSuperBlock<CountSetBits>(superBlockIndex);
+
+			const std::uint64_t entry = mSuperBlocks[superBlockIndex];
+			size_t wordIndex = superBlockIndex * sNumOfBitsInSuperBlock / detail::sNumOfBitsInWord;
+
+			for (size_t basicBlockIndex = 0; basicBlockIndex + 1 < sNumOfBasicBlocksInSuperBlock; basicBlockIndex++)
+			{
+				const size_t numOfSetBits = (entry >> getBasicBlockCountShift(basicBlockIndex)) & ((1 << sNumOfBitsInBasicBlockCount) - 1);
+				const size_t count = CountSetBits ? numOfSetBits : sNumOfBitsInBasicBlock - numOfSetBits;
+
+				if (rank < count)
+				{
+					break;
+				}
+				rank -= count;
+				wordIndex += sNumOfBitsInBasicBlock / detail::sNumOfBitsInWord;
+			}
+
+			for (;; wordIndex++)
+			{
+				const detail::word value = CountSetBits ? getWord(wordIndex) : ~getWord(wordIndex);
+				const size_t count = std::popcount(value);
+
+				if (rank < count)
+				{
+					return wordIndex * detail::sNumOfBitsInWord + detail::selectInWord(value, rank);
+				}
+				rank -= count;
+			}
+		}
+
+		detail::word getWord(size_t wordIndex) const
+		{
+			return detail::getWord(mBitset.data(), mBitset.size(), wordIndex);
+		}
+
+		Bitset mBitset{};
+
+		mutable std::vector<std::uint64_t> mUpperBlocks{};
+		mutable std::vector<std::uint64_t> mSuperBlocks{};
+
+		// The super block of every sSelectSampleRate'th unset bit, followed by the same for set bits.
+		mutable std::vector<size_t> mSelectSamples[2]{};
+		mutable size_t mNumOfSetBits{};
+		mutable bool mIsIndexUpToDate = false;
+	};
+}
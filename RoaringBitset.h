@@ -0,0 +1,667 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	namespace detail
+	{
+		// Every chunk holds the values that share their 16 most significant bits.
+		constexpr size_t sRoaringChunkSize = size_t{ 1 } << 16;
+		constexpr size_t sRoaringNumOfWordsInBitmap = sRoaringChunkSize / sNumOfBitsInWord;
+		// Above this many values, a bitmap takes less memory than an array.
+		constexpr size_t sRoaringMaxArraySize = 4096;
+
+		enum class RoaringContainerType : unsigned char
+		{
+			Array,
+			Bitmap,
+			Run
+		};
+
+		struct RoaringChunk
+		{
+			std::uint16_t key{};
+			RoaringContainerType type = RoaringContainerType::Array;
+			std::uint32_t cardinality{};
+			// The sorted values of an array, or the start and the length minus one of every run.
+			std::vector<std::uint16_t> values{};
+			// The bits of a bitmap, in the same order as the blocks of a dynamic_bitset.
+			std::vector<std::uint64_t> words{};
+		};
+
+		constexpr bit getRoaringBit(const std::uint64_t* words, std::uint16_t value)
+		{
+			return (words[value / sNumOfBitsInWord] >> (sNumOfBitsInWord - 1 - value % sNumOfBitsInWord)) & 1;
+		}
+
+		constexpr void setRoaringBit(std::uint64_t* words, std::uint16_t value)
+		{
+			words[value / sNumOfBitsInWord] |= std::uint64_t{ 1 } << (sNumOfBitsInWord - 1 - value % sNumOfBitsInWord);
+		}
+
+		// Calls the function with every set bit of the words, in increasing order.
+		template<typename Function>
+		void forEachSetBitInWords(const std::uint64_t* words, size_t numOfWords, Function&& function)
+		{
+			for (size_t i = 0; i < numOfWords; i++)
+			{
+				for (std::uint64_t word = words[i]; word != 0; word &= ~(std::uint64_t{ 1 } << (sNumOfBitsInWord - 1 - std::countl_zero(word))))
+				{
+					function(static_cast<std::uint16_t>(i * sNumOfBitsInWord + std::countl_zero(word)));
+				}
+			}
+		}
+
+		template<typename Function>
+		void forEachValue(const RoaringChunk& chunk, Function&& function)
+		{
+			switch (chunk.type)
+			{
+			case RoaringContainerType::Array:
+				for (const std::uint16_t value : chunk.values)
+				{
+					function(value);
+				}
+				break;
+			case RoaringContainerType::Bitmap:
+				forEachSetBitInWords(chunk.words.data(), chunk.words.size(), function);
+				break;
+			case RoaringContainerType::Run:
+				for (size_t i = 0; i < chunk.values.size(); i += 2)
+				{
+					for (std::uint32_t value = chunk.values[i]; value <= std::uint32_t{ chunk.values[i] } + chunk.values[i + 1]; value++)
+					{
+						function(static_cast<std::uint16_t>(value));
+					}
+				}
+				break;
+			}
+		}
+
+		inline bool contains(const RoaringChunk& chunk, std::uint16_t value)
+		{
+			switch (chunk.type)
+			{
+			case RoaringContainerType::Array:
+				return std::binary_search(chunk.values.begin(), chunk.values.end(), value);
+			case RoaringContainerType::Bitmap:
+				return getRoaringBit(chunk.words.data(), value);
+			case RoaringContainerType::Run:
+			{
+				// Finds the last run that starts at or before the value.
+				size_t low = 0;
+				size_t high = chunk.values.size() / 2;
+				while (low < high)
+				{
+					const size_t middle = (low + high) / 2;
+					if (chunk.values[middle * 2] <= value)
+					{
+						low = middle + 1;
+					}
+					else
+					{
+						high = middle;
+					}
+				}
+				return low > 0 && value - chunk.values[(low - 1) * 2] <= chunk.values[(low - 1) * 2 + 1];
+			}
+			}
+			return false;
+		}
+
+		inline void toBitmap(RoaringChunk& chunk)
+		{
+			if (chunk.type == RoaringContainerType::Bitmap)
+			{
+				return;
+			}
+
+			std::vector<std::uint64_t> words(sRoaringNumOfWordsInBitmap);
+			forEachValue(chunk, [&words](std::uint16_t value) { setRoaringBit(words.data(), value); });
+			chunk.words = std::move(words);
+			chunk.values = {};
+			chunk.type = RoaringContainerType::Bitmap;
+		}
+
+		inline void toArray(RoaringChunk& chunk)
+		{
+			if (chunk.type == RoaringContainerType::Array)
+			{
+				return;
+			}
+
+			std::vector<std::uint16_t> values;
+			values.reserve(chunk.cardinality);
+			forEachValue(chunk, [&values](std::uint16_t value) { values.push_back(value); });
+			chunk.values = std::move(values);
+			chunk.words = {};
+			chunk.type = RoaringContainerType::Array;
+		}
+
+		// Picks an array or a bitmap, whichever is smaller for the number of values.
+		inline void normalize(RoaringChunk& chunk)
+		{
+			if (chunk.cardinality <= sRoaringMaxArraySize)
+			{
+				toArray(chunk);
+			}
+			else
+			{
+				toBitmap(chunk);
+			}
+		}
+
+		inline std::uint32_t countWords(const std::vector<std::uint64_t>& words)
+		{
+			std::uint32_t numOfSetBits{};
+			for (const std::uint64_t word : words)
+			{
+				numOfSetBits += std::popcount(word);
+			}
+			return numOfSetBits;
+		}
+
+		// Runs are only used for storage, set operations work on an array or a bitmap copy of them.
+		inline const RoaringChunk& withoutRuns(const RoaringChunk& chunk, RoaringChunk& copy)
+		{
+			if (chunk.type != RoaringContainerType::Run)
+			{
+				return chunk;
+			}
+			copy = chunk;
+			normalize(copy);
+			return copy;
+		}
+
+		inline RoaringChunk intersect(const RoaringChunk& lhs, const RoaringChunk& rhs)
+		{
+			RoaringChunk result{ lhs.key };
+
+			if (lhs.type == RoaringContainerType::Bitmap && rhs.type == RoaringContainerType::Bitmap)
+			{
+				result.type = RoaringContainerType::Bitmap;
+				result.words.resize(sRoaringNumOfWordsInBitmap);
+				for (size_t i = 0; i < sRoaringNumOfWordsInBitmap; i++)
+				{
+					result.words[i] = lhs.words[i] & rhs.words[i];
+				}
+				result.cardinality = countWords(result.words);
+				normalize(result);
+			}
+			else if (lhs.type == RoaringContainerType::Array && rhs.type == RoaringContainerType::Array)
+			{
+				std::set_intersection(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(), std::back_inserter(result.values));
+				result.cardinality = static_cast<std::uint32_t>(result.values.size());
+			}
+			else
+			{
+				const RoaringChunk& array = lhs.type == RoaringContainerType::Array ? lhs : rhs;
+				const RoaringChunk& bitmap = lhs.type == RoaringContainerType::Array ? rhs : lhs;
+				for (const std::uint16_t value : array.values)
+				{
+					if (getRoaringBit(bitmap.words.data(), value))
+					{
+						result.values.push_back(value);
+					}
+				}
+				result.cardinality = static_cast<std::uint32_t>(result.values.size());
+			}
+			return result;
+		}
+
+		inline RoaringChunk unite(const RoaringChunk& lhs, const RoaringChunk& rhs)
+		{
+			if (lhs.type == RoaringContainerType::Array && rhs.type == RoaringContainerType::Array)
+			{
+				RoaringChunk result{ lhs.key };
+				std::set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(), std::back_inserter(result.values));
+				result.cardinality = static_cast<std::uint32_t>(result.values.size());
+				normalize(result);
+				return result;
+			}
+
+			RoaringChunk result = lhs.type == RoaringContainerType::Bitmap ? lhs : rhs;
+			const RoaringChunk& other = lhs.type == RoaringContainerType::Bitmap ? rhs : lhs;
+			if (other.type == RoaringContainerType::Bitmap)
+			{
+				for (size_t i = 0; i < sRoaringNumOfWordsInBitmap; i++)
+				{
+					result.words[i] |= other.words[i];
+				}
+			}
+			else
+			{
+				for (const std::uint16_t value : other.values)
+				{
+					setRoaringBit(result.words.data(), value);
+				}
+			}
+			result.cardinality = countWords(result.words);
+			return result;
+		}
+	}
+
+	// A compressed set of 32 bit values (e.g. IDs) in the style of Roaring bitmaps, for sets that are sparse
+	// in some ranges and dense in others. The values are split into chunks of 64 Ki by their 16 most
+	// significant bits, and every chunk is stored as whichever is smaller: a sorted array of up to 4096
+	// values, or a bitmap of 65536 bits. run_optimize() additionally stores chunks as runs where that is
+	// smaller still.
+	//
+	// Bit i of a dynamic_bitset corresponds to value i. A bitmap has the same bit order as the blocks of a
+	// dynamic_bitset, and a chunk lines up with 1024 of its blocks, so converting between the two and
+	// intersecting with one copies and ANDs whole words.
+	class roaring_bitset
+	{
+	public:
+		using value_type = std::uint32_t;
+
+		roaring_bitset() = default;
+
+		// Holds the index of every set bit of the bitset, which must be less than 2^32.
+		template<typename Container>
+		explicit roaring_bitset(const basic_dynamic_bitset<std::uint64_t, Container>& bitset)
+		{
+			assert(bitset.size() <= (std::uint64_t{ 1 } << 32));
+
+			const std::uint64_t* const blocks = bitset.data();
+			const size_t numOfBlocks = bitset.num_words();
+
+			for (size_t firstBlock = 0; firstBlock < numOfBlocks; firstBlock += detail::sRoaringNumOfWordsInBitmap)
+			{
+				const size_t numOfChunkBlocks = std::min(detail::sRoaringNumOfWordsInBitmap, numOfBlocks - firstBlock);
+
+				detail::RoaringChunk chunk{ static_cast<std::uint16_t>(firstBlock / detail::sRoaringNumOfWordsInBitmap) };
+				chunk.type = detail::RoaringContainerType::Bitmap;
+				chunk.words.assign(blocks + firstBlock, blocks + firstBlock + numOfChunkBlocks);
+				chunk.words.resize(detail::sRoaringNumOfWordsInBitmap);
+				chunk.cardinality = detail::countWords(chunk.words);
+
+				if (chunk.cardinality > 0)
+				{
+					detail::normalize(chunk);
+					mChunks.push_back(std::move(chunk));
+				}
+			}
+		}
+
+		// Returns a bitset in which the bit of every value is set, with a size of one past the largest value.
+		template<typename Container = std::vector<std::uint64_t>>
+		basic_dynamic_bitset<std::uint64_t, Container> to_dynamic_bitset() const
+		{
+			basic_dynamic_bitset<std::uint64_t, Container> bitset{};
+			if (mChunks.empty())
+			{
+				return bitset;
+			}
+
+			bitset.resize(static_cast<size_t>(max()) + 1);
+			std::uint64_t* const blocks = bitset.data();
+
+			for (const detail::RoaringChunk& chunk : mChunks)
+			{
+				std::uint64_t* const chunkBlocks = blocks + size_t{ chunk.key } * detail::sRoaringNumOfWordsInBitmap;
+				if (chunk.type == detail::RoaringContainerType::Bitmap)
+				{
+					// The bits past the largest value are zero, so only the blocks the bitset has are needed.
+					const size_t numOfChunkBlocks = std::min(detail::sRoaringNumOfWordsInBitmap, bitset.num_words() - size_t{ chunk.key } * detail::sRoaringNumOfWordsInBitmap);
+					std::copy_n(chunk.words.begin(), numOfChunkBlocks, chunkBlocks);
+				}
+				else
+				{
+					detail::forEachValue(chunk, [chunkBlocks](std::uint16_t value) { detail::setRoaringBit(chunkBlocks, value); });
+				}
+			}
+			return bitset;
+		}
+
+		void add(value_type value)
+		{
+			detail::RoaringChunk& chunk = getOrAddChunk(getKey(value));
+			const std::uint16_t lowBits = static_cast<std::uint16_t>(value);
+
+			if (chunk.type == detail::RoaringContainerType::Run)
+			{
+				if (detail::contains(chunk, lowBits))
+				{
+					return;
+				}
+				detail::normalize(chunk);
+			}
+
+			if (chunk.type == detail::RoaringContainerType::Bitmap)
+			{
+				if (!detail::getRoaringBit(chunk.words.data(), lowBits))
+				{
+					detail::setRoaringBit(chunk.words.data(), lowBits);
+					chunk.cardinality++;
+				}
+				return;
+			}
+
+			const auto position = std::lower_bound(chunk.values.begin(), chunk.values.end(), lowBits);
+			if (position == chunk.values.end() || *position != lowBits)
+			{
+				chunk.values.insert(position, lowBits);
+				chunk.cardinality++;
+				if (chunk.cardinality > detail::sRoaringMaxArraySize)
+				{
+					detail::toBitmap(chunk);
+				}
+			}
+		}
+
+		void remove(value_type value)
+		{
+			const auto chunkIt = findChunk(getKey(value));
+			if (chunkIt == mChunks.end())
+			{
+				return;
+			}
+
+			detail::RoaringChunk& chunk = *chunkIt;
+			const std::uint16_t lowBits = static_cast<std::uint16_t>(value);
+			if (!detail::contains(chunk, lowBits))
+			{
+				return;
+			}
+
+			if (chunk.type == detail::RoaringContainerType::Run)
+			{
+				detail::normalize(chunk);
+			}
+
+			if (chunk.type == detail::RoaringContainerType::Bitmap)
+			{
+				chunk.words[lowBits / sNumOfBitsInWord] &= ~(std::uint64_t{ 1 } << (sNumOfBitsInWord - 1 - lowBits % sNumOfBitsInWord));
+			}
+			else
+			{
+				chunk.values.erase(std::lower_bound(chunk.values.begin(), chunk.values.end(), lowBits));
+			}
+
+			chunk.cardinality--;
+			if (chunk.cardinality == 0)
+			{
+				mChunks.erase(chunkIt);
+			}
+			else if (chunk.cardinality == detail::sRoaringMaxArraySize)
+			{
+				detail::toArray(chunk);
+			}
+		}
+
+		bool contains(value_type value) const
+		{
+			const auto chunkIt = findChunk(getKey(value));
+			return chunkIt != mChunks.end() && detail::contains(*chunkIt, static_cast<std::uint16_t>(value));
+		}
+
+		// Returns the number of values.
+		size_t count() const
+		{
+			size_t numOfValues{};
+			for (const detail::RoaringChunk& chunk : mChunks)
+			{
+				numOfValues += chunk.cardinality;
+			}
+			return numOfValues;
+		}
+
+		bool empty() const
+		{
+			return mChunks.empty();
+		}
+
+		// Returns the largest value, the set must not be empty.
+		value_type max() const
+		{
+			assert(!mChunks.empty());
+
+			const detail::RoaringChunk& chunk = mChunks.back();
+			std::uint16_t largestLowBits{};
+			switch (chunk.type)
+			{
+			case detail::RoaringContainerType::Array:
+				largestLowBits = chunk.values.back();
+				break;
+			case detail::RoaringContainerType::Bitmap:
+			{
+				size_t i = detail::sRoaringNumOfWordsInBitmap - 1;
+				while (chunk.words[i] == 0)
+				{
+					i--;
+				}
+				largestLowBits = static_cast<std::uint16_t>(i * sNumOfBitsInWord + sNumOfBitsInWord - 1 - std::countr_zero(chunk.words[i]));
+				break;
+			}
+			case detail::RoaringContainerType::Run:
+				largestLowBits = static_cast<std::uint16_t>(chunk.values[chunk.values.size() - 2] + chunk.values.back());
+				break;
+			}
+			return static_cast<value_type>(chunk.key) << 16 | largestLowBits;
+		}
+
+		// Calls the function with every value, in increasing order.
+		template<typename Function>
+		void for_each_set_bit(Function&& function) const
+		{
+			for (const detail::RoaringChunk& chunk : mChunks)
+			{
+				const value_type highBits = static_cast<value_type>(chunk.key) << 16;
+				detail::forEachValue(chunk, [&function, highBits](std::uint16_t lowBits) { function(highBits | lowBits); });
+			}
+		}
+
+		// Stores chunks as runs of consecutive values wherever that takes less memory than an array or a
+		// bitmap, which is worth it for sets that are mostly contiguous ranges.
+		void run_optimize()
+		{
+			for (detail::RoaringChunk& chunk : mChunks)
+			{
+				if (chunk.type == detail::RoaringContainerType::Run)
+				{
+					continue;
+				}
+
+				std::vector<std::uint16_t> runs;
+				detail::forEachValue(chunk, [&runs](std::uint16_t value)
+				{
+					if (!runs.empty() && runs[runs.size() - 2] + runs.back() + 1 == value)
+					{
+						runs.back()++;
+					}
+					else
+					{
+						runs.push_back(value);
+						runs.push_back(0);
+					}
+				});
+
+				const size_t currentSize = chunk.type == detail::RoaringContainerType::Array ? chunk.values.size() * sizeof(std::uint16_t) : chunk.words.size() * sizeof(std::uint64_t);
+				if (runs.size() * sizeof(std::uint16_t) < currentSize)
+				{
+					chunk.values = std::move(runs);
+					chunk.words = {};
+					chunk.type = detail::RoaringContainerType::Run;
+				}
+			}
+		}
+
+		// Returns the number of bytes the values take up, not counting unused capacity.
+		size_t memory_usage() const
+		{
+			size_t numOfBytes = mChunks.size() * sizeof(detail::RoaringChunk);
+			for (const detail::RoaringChunk& chunk : mChunks)
+			{
+				numOfBytes += chunk.values.size() * sizeof(std::uint16_t) + chunk.words.size() * sizeof(std::uint64_t);
+			}
+			return numOfBytes;
+		}
+
+		friend roaring_bitset operator&(const roaring_bitset& lhs, const roaring_bitset& rhs)
+		{
+			roaring_bitset result;
+			auto lhsIt = lhs.mChunks.begin();
+			auto rhsIt = rhs.mChunks.begin();
+			detail::RoaringChunk lhsCopy;
+			detail::RoaringChunk rhsCopy;
+
+			while (lhsIt != lhs.mChunks.end() && rhsIt != rhs.mChunks.end())
+			{
+				if (lhsIt->key < rhsIt->key)
+				{
+					++lhsIt;
+				}
+				else if (rhsIt->key < lhsIt->key)
+				{
+					++rhsIt;
+				}
+				else
+				{
+					detail::RoaringChunk chunk = detail::intersect(detail::withoutRuns(*lhsIt++, lhsCopy), detail::withoutRuns(*rhsIt++, rhsCopy));
+					if (chunk.cardinality > 0)
+					{
+						result.mChunks.push_back(std::move(chunk));
+					}
+				}
+			}
+			return result;
+		}
+
+		friend roaring_bitset operator|(const roaring_bitset& lhs, const roaring_bitset& rhs)
+		{
+			roaring_bitset result;
+			auto lhsIt = lhs.mChunks.begin();
+			auto rhsIt = rhs.mChunks.begin();
+			detail::RoaringChunk lhsCopy;
+			detail::RoaringChunk rhsCopy;
+
+			while (lhsIt != lhs.mChunks.end() || rhsIt != rhs.mChunks.end())
+			{
+				if (rhsIt == rhs.mChunks.end() || (lhsIt != lhs.mChunks.end() && lhsIt->key < rhsIt->key))
+				{
+					result.mChunks.push_back(*lhsIt++);
+				}
+				else if (lhsIt == lhs.mChunks.end() || rhsIt->key < lhsIt->key)
+				{
+					result.mChunks.push_back(*rhsIt++);
+				}
+				else
+				{
+					result.mChunks.push_back(detail::unite(detail::withoutRuns(*lhsIt++, lhsCopy), detail::withoutRuns(*rhsIt++, rhsCopy)));
+				}
+			}
+			return result;
+		}
+
+		// Keeps the values whose bit is set in the bitset. Bitmap chunks are ANDed with the blocks directly.
+		template<typename Container>
+		friend roaring_bitset operator&(const roaring_bitset& lhs, const basic_dynamic_bitset<std::uint64_t, Container>& rhs)
+		{
+			roaring_bitset result;
+			const std::uint64_t* const blocks = rhs.data();
+			const size_t numOfBlocks = rhs.num_words();
+			detail::RoaringChunk copy;
+
+			for (const detail::RoaringChunk& lhsChunk : lhs.mChunks)
+			{
+				const size_t firstBlock = size_t{ lhsChunk.key } * detail::sRoaringNumOfWordsInBitmap;
+				if (firstBlock >= numOfBlocks)
+				{
+					break;
+				}
+
+				const detail::RoaringChunk& chunk = detail::withoutRuns(lhsChunk, copy);
+				const std::uint64_t* const chunkBlocks = blocks + firstBlock;
+				const size_t numOfChunkBlocks = std::min(detail::sRoaringNumOfWordsInBitmap, numOfBlocks - firstBlock);
+				detail::RoaringChunk resultChunk{ chunk.key };
+
+				if (chunk.type == detail::RoaringContainerType::Bitmap)
+				{
+					resultChunk.type = detail::RoaringContainerType::Bitmap;
+					resultChunk.words.resize(detail::sRoaringNumOfWordsInBitmap);
+					for (size_t i = 0; i < numOfChunkBlocks; i++)
+					{
+						resultChunk.words[i] = chunk.words[i] & chunkBlocks[i];
+					}
+					resultChunk.cardinality = detail::countWords(resultChunk.words);
+					detail::normalize(resultChunk);
+				}
+				else
+				{
+					// The bits past the end of the bitset are zero, so only the blocks need to be checked.
+					for (const std::uint16_t value : chunk.values)
+					{
+						if (value / sNumOfBitsInWord < numOfChunkBlocks && detail::getRoaringBit(chunkBlocks, value))
+						{
+							resultChunk.values.push_back(value);
+						}
+					}
+					resultChunk.cardinality = static_cast<std::uint32_t>(resultChunk.values.size());
+				}
+
+				if (resultChunk.cardinality > 0)
+				{
+					result.mChunks.push_back(std::move(resultChunk));
+				}
+			}
+			return result;
+		}
+
+		roaring_bitset& operator&=(const roaring_bitset& other)
+		{
+			return *this = *this & other;
+		}
+
+		roaring_bitset& operator|=(const roaring_bitset& other)
+		{
+			return *this = *this | other;
+		}
+
+		template<typename Container>
+		roaring_bitset& operator&=(const basic_dynamic_bitset<std::uint64_t, Container>& other)
+		{
+			return *this = *this & other;
+		}
+
+	private:
+		static constexpr size_t sNumOfBitsInWord = detail::sNumOfBitsInWord;
+
+		static std::uint16_t getKey(value_type value)
+		{
+			return static_cast<std::uint16_t>(value >> 16);
+		}
+
+		std::vector<detail::RoaringChunk>::iterator findChunk(std::uint16_t key)
+		{
+			const auto chunkIt = std::lower_bound(mChunks.begin(), mChunks.end(), key, [](const detail::RoaringChunk& chunk, std::uint16_t key) { return chunk.key < key; });
+			return chunkIt != mChunks.end() && chunkIt->key == key ? chunkIt : mChunks.end();
+		}
+
+		std::vector<detail::RoaringChunk>::const_iterator findChunk(std::uint16_t key) const
+		{
+			return const_cast<roaring_bitset&>(*this).findChunk(key);
+		}
+
+		detail::RoaringChunk& getOrAddChunk(std::uint16_t key)
+		{
+			const auto chunkIt = std::lower_bound(mChunks.begin(), mChunks.end(), key, [](const detail::RoaringChunk& chunk, std::uint16_t key) { return chunk.key < key; });
+			if (chunkIt != mChunks.end() && chunkIt->key == key)
+			{
+				return *chunkIt;
+			}
+			return *mChunks.insert(chunkIt, detail::RoaringChunk{ key });
+		}
+
+		// Sorted by key.
+		std::vector<detail::RoaringChunk> mChunks{};
+	};
+}
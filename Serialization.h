@@ -0,0 +1,410 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#include "BitStream.h"
+#include "BitsetView.h"
+#include "DynamicBitset.h"
+
+// The binary format of a serialized bitset is a 32 byte header followed by the blocks of the bitset:
+//
+//   offset  size  field
+//        0     4  magic, "DBIT"
+//        4     2  version, currently 1
+//        6     2  flags, bit 0 is set when the checksum is present
+//        8     1  size of a block in bytes
+//        9     1  byte order of the blocks, 0 for little endian and 1 for big endian
+//       10     6  reserved, zero
+//       16     8  number of bits
+//       24     4  CRC32C of the blocks, zero when not present
+//       28     4  reserved, zero
+//       32        the blocks, as they are in memory on the machine that wrote them
+//
+// The fields of the header are little endian. Readers reject unknown versions and flags and non-zero
+// reserved fields, so a later version of the format can't be misread. The blocks are written as they are in memory, so writing
+// and reading on machines with the same byte order is a single copy, and because the header size is a
+// multiple of the block size a memory mapped file can be viewed in place with load_view.
+namespace DB
+{
+	// Thrown when reading something that isn't a valid serialized bitset.
+	class serialization_error :
+		public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	namespace detail
+	{
+		constexpr size_t sSerializedHeaderSize = 32;
+		constexpr std::array<unsigned char, 4> sSerializedMagic{ 'D', 'B', 'I', 'T' };
+		constexpr std::uint16_t sSerializedVersion = 1;
+		constexpr std::uint16_t sSerializedChecksumFlag = 1;
+		constexpr unsigned char sSerializedLittleEndian = 0;
+		constexpr unsigned char sSerializedBigEndian = 1;
+		constexpr unsigned char sSerializedNativeEndian = std::endian::native == std::endian::little ? sSerializedLittleEndian : sSerializedBigEndian;
+		// The blocks are read in chunks of this many bytes, so that memory is only taken for the bytes that
+		// actually arrive rather than for however many bits the header claims. Up to sSerializedMaxReservedSize
+		// bytes are reserved up front though, which avoids growing the memory chunk by chunk for most inputs
+		// while bounding what a corrupt header can make a reader allocate.
+		constexpr size_t sSerializedChunkSize = size_t{ 1 } << 20;
+		constexpr size_t sSerializedMaxReservedSize = size_t{ 1 } << 26;
+
+		struct SerializedHeader
+		{
+			std::uint16_t version = sSerializedVersion;
+			std::uint16_t flags{};
+			unsigned char blockSize{};
+			unsigned char byteOrder = sSerializedNativeEndian;
+			std::uint64_t numOfBits{};
+			std::uint32_t checksum{};
+
+			// The number of bytes of the blocks following the header.
+			std::uint64_t getPayloadSize() const
+			{
+				const std::uint64_t numOfBitsInBlock = blockSize * std::uint64_t{ 8 };
+				return (numOfBits / numOfBitsInBlock + (numOfBits % numOfBitsInBlock != 0)) * blockSize;
+			}
+		};
+
+		template<typename Type>
+		inline void storeLittleEndian(unsigned char* destination, Type value)
+		{
+			for (size_t i = 0; i < sizeof(Type); i++)
+			{
+				destination[i] = static_cast<unsigned char>(value >> (i * 8));
+			}
+		}
+
+		template<typename Type>
+		inline Type loadLittleEndian(const unsigned char* source)
+		{
+			Type value{};
+			for (size_t i = 0; i < sizeof(Type); i++)
+			{
+				value |= static_cast<Type>(static_cast<Type>(source[i]) << (i * 8));
+			}
+			return value;
+		}
+
+		inline std::array<unsigned char, sSerializedHeaderSize> encodeHeader(const SerializedHeader& header)
+		{
+			std::array<unsigned char, sSerializedHeaderSize> bytes{};
+			std::memcpy(bytes.data(), sSerializedMagic.data(), sSerializedMagic.size());
+			storeLittleEndian(bytes.data() + 4, header.version);
+			storeLittleEndian(bytes.data() + 6, header.flags);
+			bytes[8] = header.blockSize;
+			bytes[9] = header.byteOrder;
+			storeLittleEndian(bytes.data() + 16, header.numOfBits);
+			storeLittleEndian(bytes.data() + 24, header.checksum);
+			return bytes;
+		}
+
+		// Throws a serialization_error if the bytes don't start with a header this version can read.
+		inline SerializedHeader decodeHeader(const unsigned char* bytes)
+		{
+			if (std::memcmp(bytes, sSerializedMagic.data(), sSerializedMagic.size()) != 0)
+			{
+				throw serialization_error("Not a serialized bitset");
+			}
+
+			SerializedHeader header;
+			header.version = loadLittleEndian<std::uint16_t>(bytes + 4);
+			header.flags = loadLittleEndian<std::uint16_t>(bytes + 6);
+			header.blockSize = bytes[8];
+			header.byteOrder = bytes[9];
+			header.numOfBits = loadLittleEndian<std::uint64_t>(bytes + 16);
+			header.checksum = loadLittleEndian<std::uint32_t>(bytes + 24);
+
+			if (header.version != sSerializedVersion)
+			{
+				throw serialization_error("Unsupported serialized bitset version");
+			}
+			if (!std::has_single_bit(header.blockSize) || header.blockSize > sizeof(std::uint64_t) || header.byteOrder > sSerializedBigEndian)
+			{
+				throw serialization_error("Invalid serialized bitset header");
+			}
+			if ((header.flags & ~sSerializedChecksumFlag) != 0 || (!(header.flags & sSerializedChecksumFlag) && header.checksum != 0))
+			{
+				throw serialization_error("Unsupported serialized bitset flags");
+			}
+			if (std::any_of(bytes + 10, bytes + 16, [](unsigned char byte) { return byte != 0; }) || loadLittleEndian<std::uint32_t>(bytes + 28) != 0)
+			{
+				throw serialization_error("Invalid serialized bitset header");
+			}
+			if (header.numOfBits > std::numeric_limits<size_t>::max())
+			{
+				throw serialization_error("Serialized bitset is too large");
+			}
+			return header;
+		}
+
+		inline constexpr std::array<std::uint32_t, 256> sCrc32cTable = []()
+		{
+			std::array<std::uint32_t, 256> table{};
+			for (std::uint32_t i = 0; i < 256; i++)
+			{
+				std::uint32_t crc = i;
+				for (int j = 0; j < 8; j++)
+				{
+					crc = (crc >> 1) ^ (crc & 1 ? 0x82F63B78u : 0u);
+				}
+				table[i] = crc;
+			}
+			return table;
+		}();
+
+		// Continues the CRC32C (Castagnoli) of the bytes before, pass 0 to start a new one.
+		inline std::uint32_t crc32c(const unsigned char* bytes, size_t numOfBytes, std::uint32_t crc = 0)
+		{
+			crc = ~crc;
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+			std::uint64_t crc64 = crc;
+			for (; numOfBytes >= sizeof(std::uint64_t); numOfBytes -= sizeof(std::uint64_t), bytes += sizeof(std::uint64_t))
+			{
+				std::uint64_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+#if defined(__SSE4_2__)
+				crc64 = _mm_crc32_u64(crc64, value);
+#else
+				crc64 = __crc32cd(static_cast<std::uint32_t>(crc64), value);
+#endif
+			}
+			crc = static_cast<std::uint32_t>(crc64);
+#endif
+
+			for (size_t i = 0; i < numOfBytes; i++)
+			{
+				crc = (crc >> 8) ^ sCrc32cTable[(crc ^ bytes[i]) & 0xFF];
+			}
+			return ~crc;
+		}
+
+		// Writes the header and then the blocks, through a function taking a pointer and a number of bytes.
+		template<typename Block, typename Container, typename WriteFunction>
+		void writeSerialized(const basic_dynamic_bitset<Block, Container>& bitset, bool withChecksum, WriteFunction&& write)
+		{
+			const unsigned char* const payload = reinterpret_cast<const unsigned char*>(bitset.data());
+			const size_t payloadSize = bitset.num_words() * sizeof(Block);
+
+			SerializedHeader header;
+			header.blockSize = static_cast<unsigned char>(sizeof(Block));
+			header.numOfBits = bitset.size();
+			if (withChecksum)
+			{
+				header.flags |= sSerializedChecksumFlag;
+				header.checksum = crc32c(payload, payloadSize);
+			}
+
+			const std::array<unsigned char, sSerializedHeaderSize> headerBytes = encodeHeader(header);
+			write(headerBytes.data(), headerBytes.size());
+			write(payload, payloadSize);
+		}
+
+		// Reads a serialized bitset through a function that fills a pointer with a number of bytes, and
+		// throws a serialization_error if it couldn't. The bitset is cleared if reading fails.
+		template<typename Block, typename Container, typename ReadFunction>
+		void readSerialized(basic_dynamic_bitset<Block, Container>& bitset, ReadFunction&& read)
+		{
+			bitset.clear();
+			std::array<unsigned char, sSerializedHeaderSize> headerBytes;
+			read(headerBytes.data(), headerBytes.size());
+			const SerializedHeader header = decodeHeader(headerBytes.data());
+			const size_t payloadSize = static_cast<size_t>(header.getPayloadSize());
+			const size_t numOfBits = static_cast<size_t>(header.numOfBits);
+			std::uint32_t checksum{};
+
+			if (header.blockSize == sizeof(Block) && (header.byteOrder == sSerializedNativeEndian || sizeof(Block) == 1))
+			{
+				// Same layout as in memory, so the blocks can be read straight into the bitset, growing it a
+				// chunk at a time. A chunk is a whole number of blocks, so growing only appends blocks.
+				try
+				{
+					bitset.reserve(std::min(payloadSize, sSerializedMaxReservedSize) * sNumOfBitsInByte);
+					for (size_t numOfBytesRead = 0; numOfBytesRead < payloadSize;)
+					{
+						const size_t numOfBytes = std::min(payloadSize - numOfBytesRead, sSerializedChunkSize);
+						bitset.resize(std::min(numOfBits, (numOfBytesRead + numOfBytes) * sNumOfBitsInByte));
+						unsigned char* const chunk = reinterpret_cast<unsigned char*>(bitset.data()) + numOfBytesRead;
+						read(chunk, numOfBytes);
+						checksum = crc32c(chunk, numOfBytes, checksum);
+						numOfBytesRead += numOfBytes;
+					}
+				}
+				catch (...)
+				{
+					bitset.clear();
+					throw;
+				}
+
+				if ((header.flags & sSerializedChecksumFlag) && checksum != header.checksum)
+				{
+					bitset.clear();
+					throw serialization_error("Serialized bitset checksum mismatch");
+				}
+
+				// Resizing to the same size clears the bits past the end, in case the writer didn't.
+				bitset.resize(numOfBits);
+				return;
+			}
+
+			// Written with other blocks, turn those into bytes in bit order, which is big endian.
+			std::vector<unsigned char> payload{};
+			payload.reserve(std::min(payloadSize, sSerializedMaxReservedSize));
+			while (payload.size() < payloadSize)
+			{
+				const size_t numOfBytesRead = payload.size();
+				payload.resize(numOfBytesRead + std::min(payloadSize - numOfBytesRead, sSerializedChunkSize));
+				read(payload.data() + numOfBytesRead, payload.size() - numOfBytesRead);
+				checksum = crc32c(payload.data() + numOfBytesRead, payload.size() - numOfBytesRead, checksum);
+			}
+
+			if ((header.flags & sSerializedChecksumFlag) && checksum != header.checksum)
+			{
+				throw serialization_error("Serialized bitset checksum mismatch");
+			}
+
+			if (header.byteOrder == sSerializedLittleEndian)
+			{
+				for (size_t i = 0; i < payload.size(); i += header.blockSize)
+				{
+					std::reverse(payload.data() + i, payload.data() + i + header.blockSize);
+				}
+			}
+
+			// Pushing back can throw partway, e.g. past the capacity of a static_capacity_bitset.
+			try
+			{
+				bitset.push_back(reinterpret_cast<const char*>(payload.data()), getNumOfBlocksNeeded<unsigned char>(numOfBits));
+				bitset.resize(numOfBits);
+			}
+			catch (...)
+			{
+				bitset.clear();
+				throw;
+			}
+		}
+	}
+
+	// Writes the bitset to the stream in the format described at the top of this file, with the blocks
+	// written in a single call. Failures are reported through the state of the stream.
+	template<typename Block, typename Container>
+	void write(std::ostream& stream, const basic_dynamic_bitset<Block, Container>& bitset, bool withChecksum = true)
+	{
+		detail::writeSerialized(bitset, withChecksum, [&stream](const unsigned char* bytes, size_t numOfBytes)
+		{
+			stream.write(reinterpret_cast<const char*>(bytes), static_cast<std::streamsize>(numOfBytes));
+		});
+	}
+
+	// Replaces the bitset with one read from the stream. When it was written with the same block size and
+	// byte order, the blocks are read straight into the bitset, in chunks so that a corrupt header can't
+	// make it allocate much more than the stream holds. Throws a serialization_error, leaving the bitset
+	// empty, if the stream ends early or doesn't hold a valid serialized bitset.
+	template<typename Block, typename Container>
+	void read(std::istream& stream, basic_dynamic_bitset<Block, Container>& bitset)
+	{
+		detail::readSerialized(bitset, [&stream](unsigned char* bytes, size_t numOfBytes)
+		{
+			if (!stream.read(reinterpret_cast<char*>(bytes), static_cast<std::streamsize>(numOfBytes)))
+			{
+				throw serialization_error("Unexpected end of serialized bitset");
+			}
+		});
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	// Writes the bitset to the file descriptor, like write(std::ostream&, ...). Throws a std::system_error
+	// if writing fails.
+	template<typename Block, typename Container>
+	void write(int fileDescriptor, const basic_dynamic_bitset<Block, Container>& bitset, bool withChecksum = true)
+	{
+		detail::writeSerialized(bitset, withChecksum, [fileDescriptor](const unsigned char* bytes, size_t numOfBytes)
+		{
+			detail::writeAll(fileDescriptor, bytes, numOfBytes);
+		});
+	}
+
+	// Replaces the bitset with one read from the file descriptor, like read(std::istream&, ...). Throws a
+	// std::system_error if reading fails.
+	template<typename Block, typename Container>
+	void read(int fileDescriptor, basic_dynamic_bitset<Block, Container>& bitset)
+	{
+		detail::readSerialized(bitset, [fileDescriptor](unsigned char* bytes, size_t numOfBytes)
+		{
+			while (numOfBytes > 0)
+			{
+				const size_t numOfBytesRead = detail::readSome(fileDescriptor, bytes, numOfBytes);
+				if (numOfBytesRead == 0)
+				{
+					throw serialization_error("Unexpected end of serialized bitset");
+				}
+				bytes += numOfBytesRead;
+				numOfBytes -= numOfBytesRead;
+			}
+		});
+	}
+#endif // __unix__ || __APPLE__
+
+	// Views a serialized bitset in place, e.g. the bytes of a mapped_file, without copying the blocks.
+	// The blocks must have been written with the same block size and byte order as this machine's, and
+	// the bytes must be aligned for Block. Verifying the checksum reads every block, pass false to only
+	// touch the pages that are actually accessed. Throws a serialization_error if the bytes can't be viewed.
+	template<typename Block = std::uint64_t>
+	basic_bitset_view<Block> load_view(std::span<const std::byte> bytes, bool verifyChecksum = true)
+	{
+		if (bytes.size() < detail::sSerializedHeaderSize)
+		{
+			throw serialization_error("Unexpected end of serialized bitset");
+		}
+
+		const unsigned char* const headerBytes = reinterpret_cast<const unsigned char*>(bytes.data());
+		const detail::SerializedHeader header = detail::decodeHeader(headerBytes);
+
+		if (header.blockSize != sizeof(Block) || (header.byteOrder != detail::sSerializedNativeEndian && sizeof(Block) != 1))
+		{
+			throw serialization_error("Serialized bitset has a different block layout, use read instead");
+		}
+		if (reinterpret_cast<std::uintptr_t>(headerBytes) % alignof(Block) != 0)
+		{
+			throw serialization_error("Serialized bitset isn't aligned for its blocks");
+		}
+
+		const std::uint64_t payloadSize = header.getPayloadSize();
+		if (bytes.size() - detail::sSerializedHeaderSize < payloadSize)
+		{
+			throw serialization_error("Unexpected end of serialized bitset");
+		}
+
+		const unsigned char* const payload = headerBytes + detail::sSerializedHeaderSize;
+		if (verifyChecksum && (header.flags & detail::sSerializedChecksumFlag) && detail::crc32c(payload, static_cast<size_t>(payloadSize)) != header.checksum)
+		{
+			throw serialization_error("Serialized bitset checksum mismatch");
+		}
+
+		return { reinterpret_cast<const Block*>(payload), static_cast<size_t>(header.numOfBits) };
+	}
+}
@@ -0,0 +1,262 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	// A vector of blocks that keeps up to NumOfInlineBlocks blocks inside the object itself, and only
+	// allocates once more blocks are needed. Meant to be used as the container of a basic_dynamic_bitset,
+	// so it only supports what the bitset needs, and only unsigned integer blocks.
+	//
+	// Unlike std::vector, moving a small_block_vector that fits inline copies the blocks, so pointers
+	// to them (and bit references) don't survive the move.
+	template<typename Block, size_t NumOfInlineBlocks, typename Allocator = std::allocator<Block>>
+	class small_block_vector
+	{
+		static_assert(std::is_unsigned<Block>::value, "Blocks must be unsigned integers");
+		static_assert(NumOfInlineBlocks > 0, "Use a std::vector if nothing should be stored inline");
+
+		using AllocatorTraits = std::allocator_traits<Allocator>;
+
+	public:
+		using value_type = Block;
+		using allocator_type = Allocator;
+		using size_type = size_t;
+
+		small_block_vector() = default;
+
+		explicit small_block_vector(const allocator_type& allocator) :
+			mAllocator(allocator)
+		{}
+
+		small_block_vector(const small_block_vector& other) :
+			small_block_vector(other, AllocatorTraits::select_on_container_copy_construction(other.mAllocator))
+		{}
+
+		small_block_vector(const small_block_vector& other, const allocator_type& allocator) :
+			mAllocator(allocator)
+		{
+			assign(other);
+		}
+
+		small_block_vector(small_block_vector&& other) noexcept :
+			mAllocator(std::move(other.mAllocator))
+		{
+			steal(other);
+		}
+
+		small_block_vector(small_block_vector&& other, const allocator_type& allocator) :
+			mAllocator(allocator)
+		{
+			if (mAllocator == other.mAllocator)
+			{
+				steal(other);
+			}
+			else
+			{
+				assign(other);
+				other.clear();
+			}
+		}
+
+		// The allocator stays the same, like the default for std::pmr containers.
+		small_block_vector& operator=(const small_block_vector& other)
+		{
+			if (this != &other)
+			{
+				assign(other);
+			}
+			return *this;
+		}
+
+		small_block_vector& operator=(small_block_vector&& other) noexcept(AllocatorTraits::is_always_equal::value)
+		{
+			if (this == &other)
+			{
+				return *this;
+			}
+
+			if (other.isInline() || mAllocator != other.mAllocator)
+			{
+				assign(other);
+				other.clear();
+			}
+			else
+			{
+				deallocate();
+				steal(other);
+			}
+			return *this;
+		}
+
+		~small_block_vector()
+		{
+			deallocate();
+		}
+
+		inline allocator_type get_allocator() const
+		{
+			return mAllocator;
+		}
+
+		inline Block* data()
+		{
+			return mBlocks;
+		}
+
+		inline const Block* data() const
+		{
+			return mBlocks;
+		}
+
+		inline size_t size() const
+		{
+			return mSize;
+		}
+
+		inline size_t capacity() const
+		{
+			return mCapacity;
+		}
+
+		inline Block& operator[](size_t index)
+		{
+#if _CONTAINER_DEBUG_LEVEL > 0
+			assert(index < mSize);
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+			return data()[index];
+		}
+
+		inline const Block& operator[](size_t index) const
+		{
+#if _CONTAINER_DEBUG_LEVEL > 0
+			assert(index < mSize);
+#endif // _CONTAINER_DEBUG_LEVEL > 0
+			return data()[index];
+		}
+
+		inline Block& back()
+		{
+			return (*this)[mSize - 1];
+		}
+
+		inline const Block& back() const
+		{
+			return (*this)[mSize - 1];
+		}
+
+		// Keeps the capacity, like std::vector.
+		inline void clear()
+		{
+			mSize = 0;
+		}
+
+		inline void resize(size_t size, Block value = Block{})
+		{
+			if (size > mCapacity)
+			{
+				reallocate(std::max(size, mCapacity * 2));
+			}
+
+			if (size > mSize)
+			{
+				std::fill(data() + mSize, data() + size, value);
+			}
+			mSize = size;
+		}
+
+		inline void reserve(size_t capacity)
+		{
+			if (capacity > mCapacity)
+			{
+				reallocate(capacity);
+			}
+		}
+
+		// Moves the blocks back inside the object if they fit.
+		inline void shrink_to_fit()
+		{
+			if (!isInline() && mSize < mCapacity)
+			{
+				reallocate(mSize);
+			}
+		}
+
+	private:
+		inline bool isInline() const
+		{
+			return mCapacity == NumOfInlineBlocks;
+		}
+
+		// Moves the blocks to storage with room for the capacity, which must be at least the size.
+		void reallocate(size_t capacity)
+		{
+			capacity = std::max(capacity, NumOfInlineBlocks);
+			if (capacity == mCapacity)
+			{
+				return;
+			}
+
+			Block* const blocks = capacity == NumOfInlineBlocks ? mInlineBlocks : AllocatorTraits::allocate(mAllocator, capacity);
+			std::copy_n(mBlocks, mSize, blocks);
+			deallocate();
+
+			mBlocks = blocks;
+			mCapacity = capacity;
+		}
+
+		void assign(const small_block_vector& other)
+		{
+			mSize = 0;
+			resize(other.mSize);
+			std::copy_n(other.data(), other.mSize, data());
+		}
+
+		// Takes the blocks of the other vector, which must use an equal allocator, and leaves it empty.
+		void steal(small_block_vector& other)
+		{
+			mSize = other.mSize;
+			mCapacity = other.mCapacity;
+			if (other.isInline())
+			{
+				std::copy_n(other.mInlineBlocks, other.mSize, mInlineBlocks);
+				mBlocks = mInlineBlocks;
+			}
+			else
+			{
+				mBlocks = other.mBlocks;
+			}
+
+			other.mBlocks = other.mInlineBlocks;
+			other.mSize = 0;
+			other.mCapacity = NumOfInlineBlocks;
+		}
+
+		void deallocate()
+		{
+			if (!isInline())
+			{
+				AllocatorTraits::deallocate(mAllocator, mBlocks, mCapacity);
+				mBlocks = mInlineBlocks;
+				mCapacity = NumOfInlineBlocks;
+			}
+		}
+
+		// Points at either the inline blocks or the heap blocks, so that data() doesn't need to branch.
+		Block* mBlocks = mInlineBlocks;
+		size_t mSize{};
+		size_t mCapacity = NumOfInlineBlocks;
+		Block mInlineBlocks[NumOfInlineBlocks]{};
+		[[no_unique_address]] Allocator mAllocator{};
+	};
+
+	// A dynamic_bitset that doesn't allocate until it grows past NumOfInlineBits bits.
+	template<size_t NumOfInlineBits = 256, typename Block = std::uint64_t, typename Allocator = std::allocator<Block>>
+	using small_dynamic_bitset = basic_dynamic_bitset<Block, small_block_vector<Block, detail::getNumOfBlocksNeeded<Block>(NumOfInlineBits), Allocator>>;
+}
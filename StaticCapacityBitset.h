@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	// A vector of blocks that stores up to Capacity blocks inside the object and never allocates.
+	// Meant to be used as the container of a basic_dynamic_bitset, so it only supports what the
+	// bitset needs. Growing past the capacity throws std::bad_alloc, like std::inplace_vector, in
+	// every build mode rather than falling back to the heap. The bitset grows its blocks before it
+	// updates its size, so a push_back that throws leaves the bitset unchanged.
+	template<typename Block, size_t Capacity>
+	class static_block_vector
+	{
+		static_assert(std::is_unsigned<Block>::value, "Blocks must be unsigned integers");
+
+	public:
+		using value_type = Block;
+		using size_type = size_t;
+
+		constexpr Block* data()
+		{
+			return mBlocks.data();
+		}
+
+		constexpr const Block* data() const
+		{
+			return mBlocks.data();
+		}
+
+		constexpr size_t size() const
+		{
+			return mSize;
+		}
+
+		constexpr size_t capacity() const
+		{
+			return Capacity;
+		}
+
+		constexpr Block& operator[](size_t index)
+		{
+			return mBlocks[index];
+		}
+
+		constexpr const Block& operator[](size_t index) const
+		{
+			return mBlocks[index];
+		}
+
+		constexpr Block& back()
+		{
+			return mBlocks[mSize - 1];
+		}
+
+		constexpr const Block& back() const
+		{
+			return mBlocks[mSize - 1];
+		}
+
+		constexpr void clear()
+		{
+			mSize = 0;
+		}
+
+		constexpr void resize(size_t size, Block value = Block{})
+		{
+			if (size > Capacity)
+			{
+				throw std::bad_alloc();
+			}
+
+			if (size > mSize)
+			{
+				std::fill(mBlocks.begin() + mSize, mBlocks.begin() + size, value);
+			}
+			mSize = size;
+		}
+
+		constexpr void reserve(size_t capacity)
+		{
+			if (capacity > Capacity)
+			{
+				throw std::bad_alloc();
+			}
+		}
+
+		constexpr void shrink_to_fit() {}
+
+	private:
+		std::array<Block, Capacity> mBlocks{};
+		size_t mSize{};
+	};
+
+	// A dynamic_bitset that can hold up to NumOfBits bits (rounded up to whole blocks) without ever
+	// allocating. It has the same interface and encoding as dynamic_bitset, so code can switch
+	// between the two through the Container parameter of basic_dynamic_bitset.
+	template<size_t NumOfBits, typename Block = std::uint64_t>
+	using static_capacity_bitset = basic_dynamic_bitset<Block, static_block_vector<Block, detail::getNumOfBlocksNeeded<Block>(NumOfBits)>>;
+}
@@ -0,0 +1,309 @@
+#pragma once
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "DynamicBitset.h"
+
+namespace DB
+{
+	// Owns a bitset and keeps a hierarchy of summaries of it, so that find_first/find_next take a handful of
+	// word operations no matter how sparse the bits are. The first summary has a bit for every 64 bit word
+	// of the bitset that has any bit set, the next one a bit for every word of the first summary that has
+	// any bit set, and so on until a summary fits in a single word. This takes about 1.6% on top of the bitset.
+	//
+	// The summaries are kept up to date on every change, which costs a few word operations when a word of
+	// the bitset goes from empty to not empty or back. Bits can be changed through set(), reset() and the
+	// references returned by operator[], but not through the bitset itself.
+	template<typename Bitset = dynamic_bitset>
+	class summary_bitset
+	{
+		static constexpr size_t sNumOfBitsInWord = detail::sNumOfBitsInWord;
+
+	public:
+		static constexpr size_t npos = detail::sNotFound;
+
+		// A reference to a single bit, which keeps the summaries up to date when assigned to.
+		class reference
+		{
+		public:
+			reference& operator=(bit value)
+			{
+				mOwner->set(mBitIndex, value);
+				return *this;
+			}
+
+			reference& operator=(const reference& other)
+			{
+				return *this = static_cast<bit>(other);
+			}
+
+			operator bit() const
+			{
+				return mOwner->test(mBitIndex);
+			}
+
+		private:
+			friend class summary_bitset;
+
+			reference(summary_bitset* owner, size_t bitIndex) :
+				mOwner(owner),
+				mBitIndex(bitIndex)
+			{}
+
+			summary_bitset* mOwner;
+			size_t mBitIndex;
+		};
+
+		summary_bitset() = default;
+
+		explicit summary_bitset(Bitset bitset) :
+			mBitset(std::move(bitset))
+		{
+			updateWords(0, mBitset.size());
+		}
+
+		inline const Bitset& bitset() const
+		{
+			return mBitset;
+		}
+
+		// Appends to the bitset, accepts anything the bitset's push_back accepts.
+		template<typename... Args>
+		inline void push_back(Args&&... args)
+		{
+			const size_t firstBitIndex = mBitset.size();
+			mBitset.push_back(std::forward<Args>(args)...);
+			updateWords(firstBitIndex, mBitset.size());
+		}
+
+		inline void write_bits(std::uint64_t value, unsigned numOfBits)
+		{
+			const size_t firstBitIndex = mBitset.size();
+			mBitset.write_bits(value, numOfBits);
+			updateWords(firstBitIndex, mBitset.size());
+		}
+
+		inline void pop_back()
+		{
+			mBitset.pop_back();
+			updateWord(mBitset.size() / sNumOfBitsInWord);
+		}
+
+		inline void clear()
+		{
+			mBitset.clear();
+			mLevels.clear();
+		}
+
+		inline bit test(size_t bitIndex) const
+		{
+			assert(bitIndex < mBitset.size());
+			return (getWord(bitIndex / sNumOfBitsInWord) >> (sNumOfBitsInWord - 1 - bitIndex % sNumOfBitsInWord)) & 1;
+		}
+
+		inline void set(size_t bitIndex, bit value = true)
+		{
+			assert(bitIndex < mBitset.size());
+			mBitset.getBitRef(bitIndex / sNumOfBitsInByte, static_cast<bit_index>(bitIndex % sNumOfBitsInByte)) = value;
+			updateWord(bitIndex / sNumOfBitsInWord);
+		}
+
+		inline void reset(size_t bitIndex)
+		{
+			set(bitIndex, false);
+		}
+
+		inline reference operator[](size_t bitIndex)
+		{
+			return { this, bitIndex };
+		}
+
+		inline bit operator[](size_t bitIndex) const
+		{
+			return test(bitIndex);
+		}
+
+		// Returns the index of the first set bit, or npos if no bits are set.
+		inline size_t find_first() const
+		{
+			return findFrom(0);
+		}
+
+		// Returns the index of the first set bit after bitIndex, or npos if there is none.
+		inline size_t find_next(size_t bitIndex) const
+		{
+			return bitIndex == npos ? npos : findFrom(bitIndex + 1);
+		}
+
+		// Calls the function with the index of every set bit, in increasing order, skipping empty words
+		// through the summaries.
+		template<typename Function>
+		inline void for_each_set_bit(Function&& function) const
+		{
+			for (size_t bitIndex = find_first(); bitIndex != npos; bitIndex = find_next(bitIndex))
+			{
+				function(bitIndex);
+			}
+		}
+
+		inline size_t count() const
+		{
+			return mBitset.count();
+		}
+
+		inline size_t size() const
+		{
+			return mBitset.size();
+		}
+
+		inline bool empty() const
+		{
+			return mBitset.empty();
+		}
+
+	private:
+		// Returns the index of the first set bit at or after bitIndex, or npos if there is none.
+		size_t findFrom(size_t bitIndex) const
+		{
+			if (bitIndex >= mBitset.size())
+			{
+				return npos;
+			}
+
+			size_t wordIndex = bitIndex / sNumOfBitsInWord;
+			const detail::word value = getWord(wordIndex) & (~detail::word{} >> (bitIndex % sNumOfBitsInWord));
+			if (value != 0)
+			{
+				return wordIndex * sNumOfBitsInWord + std::countl_zero(value);
+			}
+
+			// Climbs until a summary has a set bit at or after the position, then descends to the word.
+			size_t position = wordIndex + 1;
+			size_t level = 0;
+			for (; level < mLevels.size(); level++)
+			{
+				const std::vector<detail::word>& summary = mLevels[level];
+				const size_t summaryWordIndex = position / sNumOfBitsInWord;
+				if (summaryWordIndex < summary.size())
+				{
+					const detail::word summaryWord = summary[summaryWordIndex] & (~detail::word{} >> (position % sNumOfBitsInWord));
+					if (summaryWord != 0)
+					{
+						position = summaryWordIndex * sNumOfBitsInWord + std::countl_zero(summaryWord);
+						break;
+					}
+				}
+				position = summaryWordIndex + 1;
+			}
+
+			if (level == mLevels.size())
+			{
+				return npos;
+			}
+
+			while (level > 0)
+			{
+				level--;
+				position = position * sNumOfBitsInWord + std::countl_zero(mLevels[level][position]);
+			}
+			return position * sNumOfBitsInWord + std::countl_zero(getWord(position));
+		}
+
+		detail::word getWord(size_t wordIndex) const
+		{
+			return detail::getWord(mBitset.data(), mBitset.size(), wordIndex);
+		}
+
+		// Updates the summaries after the bits from firstBitIndex up to lastBitIndex were appended.
+		void updateWords(size_t firstBitIndex, size_t lastBitIndex)
+		{
+			if (firstBitIndex == lastBitIndex)
+			{
+				return;
+			}
+
+			const size_t firstWordIndex = firstBitIndex / sNumOfBitsInWord;
+			const size_t numOfWords = detail::getNumOfBlocksNeeded<detail::word>(lastBitIndex);
+			if (numOfWords != detail::getNumOfBlocksNeeded<detail::word>(firstBitIndex))
+			{
+				growLevels(numOfWords);
+			}
+
+			for (size_t wordIndex = firstWordIndex; wordIndex < numOfWords; wordIndex++)
+			{
+				updateWord(wordIndex);
+			}
+		}
+
+		// Makes room in the summaries for the words, adding levels until the top one is a single word.
+		void growLevels(size_t numOfWords)
+		{
+			const size_t numOfLevels = mLevels.size();
+			size_t numOfPositions = numOfWords;
+
+			for (size_t level = 0; level == 0 || numOfPositions > 1; level++)
+			{
+				const size_t numOfSummaryWords = detail::getNumOfBlocksNeeded<detail::word>(numOfPositions);
+				if (level == mLevels.size())
+				{
+					mLevels.emplace_back();
+				}
+				if (mLevels[level].size() < numOfSummaryWords)
+				{
+					mLevels[level].resize(numOfSummaryWords);
+				}
+				numOfPositions = numOfSummaryWords;
+			}
+
+			// A new level summarizes what the levels below it already hold.
+			for (size_t level = std::max<size_t>(numOfLevels, 1); level < mLevels.size(); level++)
+			{
+				const std::vector<detail::word>& below = mLevels[level - 1];
+				for (size_t i = 0; i < below.size(); i++)
+				{
+					if (below[i] != 0)
+					{
+						mLevels[level][i / sNumOfBitsInWord] |= detail::word{ 1 } << (sNumOfBitsInWord - 1 - i % sNumOfBitsInWord);
+					}
+				}
+			}
+		}
+
+		// Sets or clears the summary bits of the word, depending on whether it has any bits set.
+		void updateWord(size_t wordIndex)
+		{
+			bit isNotEmpty = wordIndex * sNumOfBitsInWord < mBitset.size() && getWord(wordIndex) != 0;
+			size_t position = wordIndex;
+
+			for (std::vector<detail::word>& summary : mLevels)
+			{
+				// Past the end after pop_back, where the summaries are already empty.
+				if (position / sNumOfBitsInWord >= summary.size())
+				{
+					return;
+				}
+
+				detail::word& summaryWord = summary[position / sNumOfBitsInWord];
+				const detail::word mask = detail::word{ 1 } << (sNumOfBitsInWord - 1 - position % sNumOfBitsInWord);
+				const bit wasNotEmpty = summaryWord != 0;
+				summaryWord = isNotEmpty ? summaryWord | mask : summaryWord & ~mask;
+
+				// The levels above only change when this summary word goes from empty to not empty or back.
+				if (wasNotEmpty == (summaryWord != 0))
+				{
+					return;
+				}
+				isNotEmpty = summaryWord != 0;
+				position /= sNumOfBitsInWord;
+			}
+		}
+
+		Bitset mBitset{};
+		// The summaries, starting with the one that summarizes the words of the bitset.
+		std::vector<std::vector<detail::word>> mLevels{};
+	};
+}
@@ -0,0 +1,891 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifdef DYNAMIC_BITSET_HAS_BOOST
+#include <boost/dynamic_bitset.hpp>
+#endif // DYNAMIC_BITSET_HAS_BOOST
+
+#include "AtomicBitset.h"
+#include "BitStream.h"
+#include "BitsetView.h"
+#include "DynamicBitset.h"
+#include "EwahBitset.h"
+#include "RankSelect.h"
+#include "RoaringBitset.h"
+#include "Serialization.h"
+#include "SmallDynamicBitset.h"
+#include "StaticCapacityBitset.h"
+#include "SummaryBitset.h"
+
+namespace
+{
+	using byte_bitset = DB::basic_dynamic_bitset<unsigned char>;
+
+	struct Record
+	{
+		std::uint32_t mId;
+		float mPosition[3];
+		std::uint16_t mFlags;
+	};
+
+	// Value initializes the record first, so that its padding is zero rather than uninitialized when its
+	// bytes are pushed back.
+	Record makeRecord(std::uint32_t id)
+	{
+		Record record{};
+		record.mId = id;
+		record.mPosition[0] = 1.0f;
+		record.mPosition[1] = 2.0f;
+		record.mPosition[2] = 3.0f;
+		record.mFlags = 7;
+		return record;
+	}
+
+	constexpr size_t sNumOfBits = 1 << 20;
+
+	// Every third bit is set, so the branches on the value of a bit can't be predicted perfectly.
+	inline bool getPatternBit(size_t index)
+	{
+		return index % 3 == 0;
+	}
+
+	template<typename Bitset>
+	Bitset makeBitset(size_t numOfBits)
+	{
+		Bitset bitset{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			bitset.push_back(getPatternBit(i));
+		}
+		return bitset;
+	}
+
+	template<typename Bitset>
+	void BM_PushBackBit(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			for (size_t i = 0; i < sNumOfBits; i++)
+			{
+				bitset.push_back(getPatternBit(i));
+			}
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_PushBackBitReserved(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			bitset.reserve(sNumOfBits);
+			for (size_t i = 0; i < sNumOfBits; i++)
+			{
+				bitset.push_back(getPatternBit(i));
+			}
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	// Pushes back the same bits through a bit_writer, which only keeps one chunk in memory.
+	void BM_PushBackBitStreaming(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			size_t numOfBytesFlushed{};
+			DB::bit_writer writer{ [&numOfBytesFlushed](std::span<const std::byte> bytes) { numOfBytesFlushed += bytes.size(); } };
+			for (size_t i = 0; i < sNumOfBits; i++)
+			{
+				writer.push_back(getPatternBit(i));
+			}
+			writer.finish();
+			benchmark::DoNotOptimize(numOfBytesFlushed);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_Resize(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			bitset.resize(sNumOfBits, true);
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_PushBackByte(benchmark::State& state)
+	{
+		constexpr size_t numOfBytes = sNumOfBits / DB::sNumOfBitsInByte;
+
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			bitset.push_back(state.range(0) != 0);
+
+			for (size_t i = 0; i < numOfBytes; i++)
+			{
+				bitset.push_back(DB::byte{ static_cast<unsigned char>(i) });
+			}
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetBytesProcessed(state.iterations() * numOfBytes);
+	}
+
+	template<typename Bitset>
+	void BM_PushBackTriviallyCopyable(benchmark::State& state)
+	{
+		constexpr size_t numOfRecords = sNumOfBits / (sizeof(Record) * DB::sNumOfBitsInByte);
+		const Record record{ 42, { 1.0f, 2.0f, 3.0f }, 7 };
+
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			if (state.range(0) != 0)
+			{
+				bitset.push_back(true);
+			}
+
+			for (size_t i = 0; i < numOfRecords; i++)
+			{
+				bitset.push_back(record);
+			}
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetBytesProcessed(state.iterations() * numOfRecords * sizeof(Record));
+	}
+
+	template<typename Bitset>
+	void BM_ExtractTriviallyCopyable(benchmark::State& state)
+	{
+		constexpr size_t numOfRecords = sNumOfBits / (sizeof(Record) * DB::sNumOfBitsInByte);
+		const bool isUnaligned = state.range(0) != 0;
+
+		Bitset bitset{};
+		if (isUnaligned)
+		{
+			bitset.push_back(true);
+		}
+
+		for (size_t i = 0; i < numOfRecords; i++)
+		{
+			bitset.push_back(makeRecord(static_cast<std::uint32_t>(i)));
+		}
+
+		for (auto _ : state)
+		{
+			auto it = bitset.begin();
+			if (isUnaligned)
+			{
+				++it;
+			}
+
+			for (size_t i = 0; i < numOfRecords; i++)
+			{
+				benchmark::DoNotOptimize(Bitset::template extract<Record>(it));
+			}
+		}
+		state.SetBytesProcessed(state.iterations() * numOfRecords * sizeof(Record));
+	}
+
+	// Extracts state.range(0) bytes in one go, starting state.range(1) bits into the bitset.
+	template<typename Bitset>
+	void BM_ExtractBytes(benchmark::State& state)
+	{
+		const size_t numOfBytes = static_cast<size_t>(state.range(0));
+		const DB::bit_index bitIndex = static_cast<DB::bit_index>(state.range(1));
+
+		Bitset bitset{};
+		for (DB::bit_index i = 0; i < bitIndex; i++)
+		{
+			bitset.push_back(true);
+		}
+
+		std::vector<char> buffer(numOfBytes, 0x55);
+		bitset.push_back(buffer.data(), buffer.size());
+
+		for (auto _ : state)
+		{
+			bitset.extract(buffer.data(), buffer.size(), 0, bitIndex);
+			benchmark::DoNotOptimize(buffer.data());
+			benchmark::ClobberMemory();
+		}
+		state.SetBytesProcessed(state.iterations() * numOfBytes);
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	// A file of pattern bytes in the temporary directory, written once and shared by the loading benchmarks.
+	const std::string& getBitsetFile()
+	{
+		static const std::string path = []
+		{
+			const std::string path = (std::filesystem::temp_directory_path() / "DynamicBitsetBenchmarks.bin").string();
+			const std::vector<char> bytes(1 << 26, 0x55);
+			std::ofstream file(path, std::ios::binary);
+			file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			return path;
+		}();
+		return path;
+	}
+
+	// Reads the whole file into a bitset before extracting a value from the middle of it.
+	void BM_LoadFile(benchmark::State& state)
+	{
+		const std::string& path = getBitsetFile();
+
+		for (auto _ : state)
+		{
+			std::ifstream file(path, std::ios::binary);
+			std::vector<char> bytes(std::filesystem::file_size(path));
+			file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+			DB::dynamic_bitset bitset{};
+			bitset.push_back(bytes.data(), bytes.size());
+			benchmark::DoNotOptimize(bitset.extract<Record>(bytes.size() / 2, 3));
+		}
+	}
+
+	// Maps the file instead, which only loads the pages that are accessed.
+	void BM_MapFile(benchmark::State& state)
+	{
+		const std::string& path = getBitsetFile();
+
+		for (auto _ : state)
+		{
+			const DB::mapped_bitset bitset{ path.c_str() };
+			benchmark::DoNotOptimize(bitset.extract<Record>(bitset.size_in_bytes() / 2, 3));
+		}
+	}
+
+	// The same bits as getBitsetFile, in the serialized format.
+	const std::string& getSerializedBitsetFile()
+	{
+		static const std::string path = []
+		{
+			const std::string path = (std::filesystem::temp_directory_path() / "DynamicBitsetBenchmarks.dbit").string();
+			const std::vector<char> bytes(1 << 26, 0x55);
+			DB::dynamic_bitset bitset{};
+			bitset.push_back(bytes.data(), bytes.size());
+
+			std::ofstream file(path, std::ios::binary);
+			DB::write(file, bitset);
+			return path;
+		}();
+		return path;
+	}
+
+	// Reads the blocks straight into the bitset and verifies the checksum.
+	void BM_ReadSerialized(benchmark::State& state)
+	{
+		const std::string& path = getSerializedBitsetFile();
+
+		for (auto _ : state)
+		{
+			std::ifstream file(path, std::ios::binary);
+			DB::dynamic_bitset bitset{};
+			DB::read(file, bitset);
+			benchmark::DoNotOptimize(bitset.extract<Record>(bitset.size_in_bytes() / 2, 3));
+		}
+	}
+
+	// Views the blocks in place, without verifying the checksum so only the accessed pages are loaded.
+	void BM_LoadViewSerialized(benchmark::State& state)
+	{
+		const std::string& path = getSerializedBitsetFile();
+
+		for (auto _ : state)
+		{
+			const DB::mapped_file file{ path.c_str() };
+			const DB::basic_bitset_view<std::uint64_t> bitset = DB::load_view(file.bytes(), false);
+			benchmark::DoNotOptimize(bitset.extract<Record>(bitset.size_in_bytes() / 2, 3));
+		}
+	}
+#endif // __unix__ || __APPLE__
+
+	// Decodes 13 bit fields from a bitset that is already in memory.
+	void BM_ReadBits(benchmark::State& state)
+	{
+		DB::dynamic_bitset bitset = makeBitset<DB::dynamic_bitset>(sNumOfBits);
+		constexpr unsigned sNumOfBitsInField = 13;
+
+		for (auto _ : state)
+		{
+			std::uint64_t sum{};
+			DB::dynamic_bitset::iterator it = bitset.begin();
+			for (size_t i = 0; i + sNumOfBitsInField <= sNumOfBits; i += sNumOfBitsInField)
+			{
+				sum += DB::dynamic_bitset::read_bits(it, sNumOfBitsInField);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	// Decodes the same fields through a bit_reader, which pulls the bytes in through a bounded buffer.
+	void BM_ReadBitsStreaming(benchmark::State& state)
+	{
+		DB::dynamic_bitset bitset = makeBitset<DB::dynamic_bitset>(sNumOfBits);
+		std::vector<char> bytes(bitset.size_in_bytes());
+		bitset.extract(bytes.data(), bytes.size(), 0, 0);
+		constexpr unsigned sNumOfBitsInField = 13;
+
+		for (auto _ : state)
+		{
+			size_t offset{};
+			DB::bit_reader reader{ [&bytes, &offset](std::span<std::byte> destination)
+			{
+				const size_t numOfBytes = std::min(destination.size(), bytes.size() - offset);
+				std::memcpy(destination.data(), bytes.data() + offset, numOfBytes);
+				offset += numOfBytes;
+				return numOfBytes;
+			} };
+
+			std::uint64_t sum{};
+			for (size_t i = 0; i + sNumOfBitsInField <= sNumOfBits; i += sNumOfBitsInField)
+			{
+				sum += reader.read_bits(sNumOfBitsInField);
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_Iterate(benchmark::State& state)
+	{
+		const Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+
+		for (auto _ : state)
+		{
+			size_t numOfSetBits{};
+			for (auto it = bitset.begin(); it != bitset.end(); ++it)
+			{
+				numOfSetBits += *it;
+			}
+			benchmark::DoNotOptimize(numOfSetBits);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	void BM_IterateStdBitset(benchmark::State& state)
+	{
+		std::bitset<sNumOfBits> bitset{};
+		for (size_t i = 0; i < sNumOfBits; i++)
+		{
+			bitset[i] = getPatternBit(i);
+		}
+
+		for (auto _ : state)
+		{
+			size_t numOfSetBits{};
+			for (size_t i = 0; i < sNumOfBits; i++)
+			{
+				numOfSetBits += bitset[i];
+			}
+			benchmark::DoNotOptimize(numOfSetBits);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	// A sorted bitset (zeros followed by ones) is searched with std::lower_bound,
+	// which only takes O(log n) steps when the iterators are random access.
+	template<typename Bitset>
+	void BM_LowerBound(benchmark::State& state)
+	{
+		Bitset bitset{};
+		for (size_t i = 0; i < sNumOfBits; i++)
+		{
+			bitset.push_back(i >= sNumOfBits / 3);
+		}
+
+		const Bitset& constBitset = bitset;
+		for (auto _ : state)
+		{
+			auto it = std::lower_bound(constBitset.begin(), constBitset.end(), true);
+			benchmark::DoNotOptimize(it);
+		}
+	}
+
+	template<typename Bitset>
+	void BM_Count(benchmark::State& state)
+	{
+		const Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+
+		for (auto _ : state)
+		{
+			if constexpr (std::is_same_v<Bitset, std::vector<bool>>)
+			{
+				benchmark::DoNotOptimize(std::count(bitset.begin(), bitset.end(), true));
+			}
+			else
+			{
+				benchmark::DoNotOptimize(bitset.count());
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	void BM_CountStdBitset(benchmark::State& state)
+	{
+		std::bitset<sNumOfBits> bitset{};
+		for (size_t i = 0; i < sNumOfBits; i++)
+		{
+			bitset[i] = getPatternBit(i);
+		}
+
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(bitset.count());
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_BitwiseAnd(benchmark::State& state)
+	{
+		Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+		const Bitset other = ~bitset;
+
+		for (auto _ : state)
+		{
+			bitset &= other;
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetBytesProcessed(state.iterations() * sNumOfBits / DB::sNumOfBitsInByte);
+	}
+
+	// One in every thousand bits is set.
+	template<typename Bitset>
+	Bitset makeSparseBitset(size_t numOfBits)
+	{
+		Bitset bitset{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			bitset.push_back(i % 1000 == 999);
+		}
+		return bitset;
+	}
+
+	template<typename Bitset>
+	void BM_FindNext(benchmark::State& state)
+	{
+		const Bitset bitset = makeSparseBitset<Bitset>(sNumOfBits);
+
+		for (auto _ : state)
+		{
+			size_t sum{};
+			for (size_t bitIndex = bitset.find_first(); bitIndex != Bitset::npos; bitIndex = bitset.find_next(bitIndex))
+			{
+				sum += bitIndex;
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_ForEachSetBit(benchmark::State& state)
+	{
+		const Bitset bitset = makeSparseBitset<Bitset>(sNumOfBits);
+
+		for (auto _ : state)
+		{
+			size_t sum{};
+			bitset.for_each_set_bit([&sum](size_t bitIndex) { sum += bitIndex; });
+			benchmark::DoNotOptimize(sum);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	// One in every hundred thousand bits is set, so most words are all zeros.
+	template<typename Bitset>
+	Bitset makeVerySparseBitset(size_t numOfBits)
+	{
+		DB::dynamic_bitset bitset{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			bitset.push_back(i % 100000 == 99999);
+		}
+
+		if constexpr (std::is_same_v<Bitset, DB::dynamic_bitset>)
+		{
+			return bitset;
+		}
+		else
+		{
+			return Bitset{ bitset };
+		}
+	}
+
+	template<typename Bitset>
+	void BM_CountVerySparse(benchmark::State& state)
+	{
+		const Bitset bitset = makeVerySparseBitset<Bitset>(sNumOfBits);
+
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(bitset.count());
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_BitwiseOrVerySparse(benchmark::State& state)
+	{
+		const Bitset bitset = makeVerySparseBitset<Bitset>(sNumOfBits);
+		const Bitset other = makeVerySparseBitset<Bitset>(sNumOfBits / 2);
+
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(bitset | other);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	constexpr size_t sNumOfIds = 100000;
+	constexpr size_t sIdRange = size_t{ 1 } << 26;
+
+	// A set of random IDs, as a bitset with a bit per possible ID or as a roaring_bitset.
+	template<typename Set>
+	Set makeIdSet(std::uint64_t seed)
+	{
+		DB::dynamic_bitset bitset{};
+		bitset.resize(sIdRange);
+		for (size_t i = 0; i < sNumOfIds; i++)
+		{
+			seed = seed * 6364136223846793005u + 1442695040888963407u;
+			bitset.getBitRef((seed >> 32) % sIdRange / DB::sNumOfBitsInByte, static_cast<DB::bit_index>((seed >> 32) % DB::sNumOfBitsInByte)) = true;
+		}
+
+		if constexpr (std::is_same_v<Set, DB::dynamic_bitset>)
+		{
+			return bitset;
+		}
+		else
+		{
+			return Set{ bitset };
+		}
+	}
+
+	template<typename Set>
+	void BM_IntersectIds(benchmark::State& state)
+	{
+		const Set ids = makeIdSet<Set>(1);
+		const Set other = makeIdSet<Set>(2);
+
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize((ids & other).count());
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfIds);
+	}
+
+	constexpr size_t sNumOfHugeBits = size_t{ 1 } << 30;
+
+	// Finds the set bits of a 2^30 bit set with only 64 bits set, where scanning is dominated by empty words.
+	template<typename Bitset>
+	void BM_FindNextHugeSparse(benchmark::State& state)
+	{
+		DB::dynamic_bitset bitset{};
+		bitset.resize(sNumOfHugeBits);
+		for (size_t i = 0; i < sNumOfHugeBits; i += sNumOfHugeBits / 64)
+		{
+			bitset.getBitRef((i + 12345) / DB::sNumOfBitsInByte, static_cast<DB::bit_index>((i + 12345) % DB::sNumOfBitsInByte)) = true;
+		}
+		const Bitset huge{ std::move(bitset) };
+
+		for (auto _ : state)
+		{
+			size_t sum{};
+			for (size_t bitIndex = huge.find_first(); bitIndex != Bitset::npos; bitIndex = huge.find_next(bitIndex))
+			{
+				sum += bitIndex;
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+	}
+
+	constexpr size_t sNumOfSlots = 4096;
+
+	// Claims and releases a slot of an occupancy map shared by all the threads of the benchmark.
+	void BM_AllocateSlot(benchmark::State& state)
+	{
+		static DB::dynamic_bitset slots = []
+		{
+			DB::dynamic_bitset bitset{};
+			bitset.resize(sNumOfSlots);
+			return bitset;
+		}();
+		const DB::atomic_bitset_view view{ slots };
+
+		for (auto _ : state)
+		{
+			const size_t slot = view.set_first_zero(0, std::memory_order_acquire);
+			benchmark::DoNotOptimize(slot);
+			view.test_and_reset(slot, std::memory_order_release);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	template<typename Bitset>
+	void BM_Rank(benchmark::State& state)
+	{
+		const Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+		size_t bitIndex{};
+
+		for (auto _ : state)
+		{
+			// Steps through the bitset in strides that are not a multiple of any block size.
+			bitIndex = (bitIndex + 100003) % sNumOfBits;
+			benchmark::DoNotOptimize(bitset.rank(bitIndex));
+		}
+	}
+
+	void BM_RankSelectRank1(benchmark::State& state)
+	{
+		const DB::rank_select_bitset<> bitset{ makeBitset<DB::dynamic_bitset>(sNumOfBits) };
+		bitset.rebuild_index();
+		size_t bitIndex{};
+
+		for (auto _ : state)
+		{
+			bitIndex = (bitIndex + 100003) % sNumOfBits;
+			benchmark::DoNotOptimize(bitset.rank1(bitIndex));
+		}
+	}
+
+	void BM_RankSelectSelect1(benchmark::State& state)
+	{
+		const DB::rank_select_bitset<> bitset{ makeBitset<DB::dynamic_bitset>(sNumOfBits) };
+		bitset.rebuild_index();
+		const size_t numOfSetBits = bitset.bitset().count();
+		size_t rank{};
+
+		for (auto _ : state)
+		{
+			rank = (rank + 100003) % numOfSetBits;
+			benchmark::DoNotOptimize(bitset.select1(rank));
+		}
+	}
+
+	// Selects in a 2^30 bit set with only 64 bits set, where all of them fall between two select samples.
+	void BM_RankSelectSelect1Sparse(benchmark::State& state)
+	{
+		DB::dynamic_bitset bitset{};
+		bitset.resize(sNumOfHugeBits);
+		for (size_t i = 0; i < sNumOfHugeBits; i += sNumOfHugeBits / 64)
+		{
+			bitset.getBitRef((i + 12345) / DB::sNumOfBitsInByte, static_cast<DB::bit_index>((i + 12345) % DB::sNumOfBitsInByte)) = true;
+		}
+		const DB::rank_select_bitset<> sparse{ std::move(bitset) };
+		sparse.rebuild_index();
+		size_t rank{};
+
+		for (auto _ : state)
+		{
+			rank = (rank + 17) % 64;
+			benchmark::DoNotOptimize(sparse.select1(rank));
+		}
+	}
+
+	template<typename Bitset>
+	void BM_PopBack(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+			state.ResumeTiming();
+
+			for (size_t i = 0; i < sNumOfBits; i++)
+			{
+				bitset.pop_back();
+			}
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetItemsProcessed(state.iterations() * sNumOfBits);
+	}
+
+	template<typename Bitset>
+	void BM_Clear(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Bitset bitset = makeBitset<Bitset>(sNumOfBits);
+			state.ResumeTiming();
+
+			bitset.clear();
+			benchmark::DoNotOptimize(bitset);
+		}
+	}
+
+	constexpr size_t sNumOfShortLivedBits = 200;
+
+	// Many small, short-lived bitsets, where the cost is dominated by allocating the blocks.
+	template<typename Bitset>
+	void BM_ShortLived(benchmark::State& state)
+	{
+		for (auto _ : state)
+		{
+			Bitset bitset{};
+			bitset.resize(sNumOfShortLivedBits, true);
+			benchmark::DoNotOptimize(bitset);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	void BM_ShortLivedPmr(benchmark::State& state)
+	{
+		std::byte buffer[1 << 12];
+		std::pmr::monotonic_buffer_resource arena{ buffer, sizeof(buffer) };
+
+		for (auto _ : state)
+		{
+			{
+				DB::pmr::dynamic_bitset bitset{ &arena };
+				bitset.resize(sNumOfShortLivedBits, true);
+				benchmark::DoNotOptimize(bitset);
+			}
+			arena.release();
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+}
+
+BENCHMARK_TEMPLATE(BM_PushBackBit, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_PushBackBit, byte_bitset);
+BENCHMARK_TEMPLATE(BM_PushBackBit, DB::small_dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_PushBackBit, std::vector<bool>);
+
+BENCHMARK_TEMPLATE(BM_PushBackBitReserved, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_PushBackBitReserved, std::vector<bool>);
+BENCHMARK(BM_PushBackBitStreaming);
+
+BENCHMARK_TEMPLATE(BM_Resize, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_Resize, std::vector<bool>);
+
+BENCHMARK_TEMPLATE(BM_PushBackByte, DB::dynamic_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PushBackByte, byte_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+
+BENCHMARK_TEMPLATE(BM_PushBackTriviallyCopyable, DB::dynamic_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PushBackTriviallyCopyable, byte_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+
+BENCHMARK_TEMPLATE(BM_ExtractTriviallyCopyable, DB::dynamic_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ExtractTriviallyCopyable, byte_bitset)->ArgName("unaligned")->Arg(0)->Arg(1);
+
+// 1 KiB to 1 GiB, byte aligned versus 3 bits into a byte.
+BENCHMARK_TEMPLATE(BM_ExtractBytes, DB::dynamic_bitset)->ArgNames({ "bytes", "bit" })
+	->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 30, 32), { 0, 3 } })->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ExtractBytes, byte_bitset)->ArgNames({ "bytes", "bit" })
+	->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 30, 32), { 0, 3 } })->Unit(benchmark::kMicrosecond);
+
+#if defined(__unix__) || defined(__APPLE__)
+BENCHMARK(BM_LoadFile)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MapFile)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadSerialized)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadViewSerialized)->Unit(benchmark::kMillisecond);
+#endif // __unix__ || __APPLE__
+
+BENCHMARK(BM_ReadBits);
+BENCHMARK(BM_ReadBitsStreaming);
+
+BENCHMARK_TEMPLATE(BM_Iterate, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_Iterate, byte_bitset);
+BENCHMARK_TEMPLATE(BM_Iterate, std::vector<bool>);
+BENCHMARK(BM_IterateStdBitset);
+
+BENCHMARK_TEMPLATE(BM_LowerBound, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_LowerBound, std::vector<bool>);
+
+BENCHMARK_TEMPLATE(BM_Count, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_Count, byte_bitset);
+BENCHMARK_TEMPLATE(BM_Count, std::vector<bool>);
+BENCHMARK(BM_CountStdBitset);
+
+BENCHMARK_TEMPLATE(BM_BitwiseAnd, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_BitwiseAnd, byte_bitset);
+
+BENCHMARK_TEMPLATE(BM_FindNext, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_FindNext, byte_bitset);
+BENCHMARK_TEMPLATE(BM_ForEachSetBit, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_ForEachSetBit, byte_bitset);
+
+BENCHMARK_TEMPLATE(BM_CountVerySparse, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_CountVerySparse, DB::ewah_bitset);
+BENCHMARK_TEMPLATE(BM_BitwiseOrVerySparse, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_BitwiseOrVerySparse, DB::ewah_bitset);
+
+BENCHMARK_TEMPLATE(BM_IntersectIds, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_IntersectIds, DB::roaring_bitset);
+
+BENCHMARK_TEMPLATE(BM_FindNextHugeSparse, DB::dynamic_bitset)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_FindNextHugeSparse, DB::summary_bitset<>)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_AllocateSlot)->Threads(1)->Threads(4)->Threads(8);
+
+BENCHMARK_TEMPLATE(BM_Rank, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_Rank, byte_bitset);
+
+BENCHMARK(BM_RankSelectRank1);
+BENCHMARK(BM_RankSelectSelect1);
+BENCHMARK(BM_RankSelectSelect1Sparse);
+
+BENCHMARK_TEMPLATE(BM_PopBack, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_PopBack, byte_bitset);
+BENCHMARK_TEMPLATE(BM_PopBack, std::vector<bool>);
+
+BENCHMARK_TEMPLATE(BM_Clear, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_Clear, byte_bitset);
+BENCHMARK_TEMPLATE(BM_Clear, std::vector<bool>);
+
+BENCHMARK_TEMPLATE(BM_ShortLived, DB::dynamic_bitset);
+BENCHMARK_TEMPLATE(BM_ShortLived, DB::small_dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_ShortLived, DB::static_capacity_bitset<sNumOfShortLivedBits>);
+BENCHMARK_TEMPLATE(BM_ShortLived, std::vector<bool>);
+BENCHMARK(BM_ShortLivedPmr);
+
+#ifdef DYNAMIC_BITSET_HAS_BOOST
+BENCHMARK_TEMPLATE(BM_PushBackBit, boost::dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_Count, boost::dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_BitwiseAnd, boost::dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_FindNext, boost::dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_PopBack, boost::dynamic_bitset<>);
+BENCHMARK_TEMPLATE(BM_Clear, boost::dynamic_bitset<>);
+
+void BM_IterateBoostDynamicBitset(benchmark::State& state)
+{
+	const boost::dynamic_bitset<> bitset = makeBitset<boost::dynamic_bitset<>>(sNumOfBits);
+
+	for (auto _ : state)
+	{
+		size_t numOfSetBits{};
+		for (size_t i = 0; i < bitset.size(); i++)
+		{
+			numOfSetBits += bitset[i];
+		}
+		benchmark::DoNotOptimize(numOfSetBits);
+	}
+	state.SetItemsProcessed(state.iterations() * sNumOfBits);
+}
+BENCHMARK(BM_IterateBoostDynamicBitset);
+#endif // DYNAMIC_BITSET_HAS_BOOST
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "AtomicBitset.h"
+#include "Check.h"
+#include "DynamicBitset.h"
+
+// The single threaded tests compare the view with the same changes to a plain bitset. The concurrent
+// ones let several threads change bits that share words, and check that no change got lost through
+// count(), which they can only all pass if every operation is atomic. They are meant to also be run
+// with DYNAMIC_BITSET_TEST_SANITIZERS=thread.
+namespace
+{
+	constexpr size_t sNumOfBitsInWord = DB::detail::sNumOfBitsInWord;
+	constexpr size_t sNumOfThreads = 8;
+
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	DB::bit getBit(const DB::dynamic_bitset& bitset, size_t bitIndex)
+	{
+		return bitset.get(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte));
+	}
+
+	void setBit(DB::dynamic_bitset& bitset, size_t bitIndex, DB::bit value)
+	{
+		bitset.getBitRef(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte)) = value;
+	}
+
+	bool isSame(const DB::dynamic_bitset& lhs, const DB::dynamic_bitset& rhs)
+	{
+		return lhs.size() == rhs.size() && std::equal(lhs.data(), lhs.data() + lhs.num_words(), rhs.data(), rhs.data() + rhs.num_words());
+	}
+
+	// Runs the function on every thread, with the index of the thread.
+	template<typename Function>
+	void runOnThreads(Function&& function)
+	{
+		std::vector<std::thread> threads{};
+		for (size_t threadIndex = 0; threadIndex < sNumOfThreads; threadIndex++)
+		{
+			threads.emplace_back(function, threadIndex);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// Every operation changes the bits like the same change to a plain bitset, and returns what was
+	// there before.
+	void testOperations()
+	{
+		for (const size_t numOfBits : { 1, 63, 64, 65, 130, 1000 })
+		{
+			DB::dynamic_bitset bitset{};
+			bitset.resize(numOfBits);
+			DB::dynamic_bitset expected = bitset;
+			const DB::atomic_bitset_view view(bitset);
+
+			for (size_t i = 0; i < 1000; i++)
+			{
+				const size_t bitIndex = sRandom() % numOfBits;
+				switch (sRandom() % 5)
+				{
+				case 0:
+					DB_CHECK(view.test_and_set(bitIndex) == getBit(expected, bitIndex));
+					setBit(expected, bitIndex, true);
+					break;
+				case 1:
+					DB_CHECK(view.test_and_reset(bitIndex, std::memory_order_relaxed) == getBit(expected, bitIndex));
+					setBit(expected, bitIndex, false);
+					break;
+				case 2:
+				{
+					const size_t lastBitIndex = bitIndex + sRandom() % (numOfBits - bitIndex + 1);
+					const DB::bit value = (sRandom() & 1) != 0;
+					if (value)
+					{
+						view.set_range(bitIndex, lastBitIndex);
+					}
+					else
+					{
+						view.reset_range(bitIndex, lastBitIndex, std::memory_order_release);
+					}
+					for (size_t j = bitIndex; j < lastBitIndex; j++)
+					{
+						setBit(expected, j, value);
+					}
+					break;
+				}
+				case 3:
+				{
+					// Only bits within the bitset may be ORed in.
+					const size_t wordIndex = bitIndex / sNumOfBitsInWord;
+					const size_t numOfBitsInWord = std::min(numOfBits - wordIndex * sNumOfBitsInWord, sNumOfBitsInWord);
+					const std::uint64_t mask = sRandom() & ~DB::detail::getLowMask(sNumOfBitsInWord - numOfBitsInWord);
+					DB_CHECK(view.fetch_or_word(wordIndex, mask) == expected.data()[wordIndex]);
+					expected.data()[wordIndex] |= mask;
+					break;
+				}
+				default:
+				{
+					const size_t setBitIndex = view.set_first_zero(bitIndex);
+					DB_CHECK(setBitIndex == (bitIndex == 0 ? expected.find_first_zero() : expected.find_next_zero(bitIndex - 1)));
+					if (setBitIndex != DB::atomic_bitset_view::npos)
+					{
+						setBit(expected, setBitIndex, true);
+					}
+					break;
+				}
+				}
+				DB_CHECK(isSame(bitset, expected));
+				DB_CHECK(view.count() == expected.count() && view.test(bitIndex) == getBit(expected, bitIndex));
+			}
+			DB_CHECK(view.set_first_zero(numOfBits) == DB::atomic_bitset_view::npos);
+		}
+	}
+
+	// All threads race to set every bit, and exactly one of them wins each.
+	void testConcurrentTestAndSet()
+	{
+		constexpr size_t numOfBits = 1000;
+
+		DB::dynamic_bitset bitset{};
+		bitset.resize(numOfBits);
+		const DB::atomic_bitset_view view(bitset);
+		std::atomic<size_t> numOfBitsWon{};
+
+		runOnThreads([&view, &numOfBitsWon](size_t threadIndex)
+		{
+			size_t numOfBitsWonByThread{};
+			for (size_t i = 0; i < numOfBits; i++)
+			{
+				// The threads start at different bits, so they also race in the middle of words.
+				numOfBitsWonByThread += !view.test_and_set((i + threadIndex * 37) % numOfBits, std::memory_order_acq_rel);
+			}
+			numOfBitsWon += numOfBitsWonByThread;
+		});
+
+		DB_CHECK(numOfBitsWon == numOfBits && view.count() == numOfBits && bitset.count() == numOfBits);
+	}
+
+	// Every thread owns every eighth bit of the same words, and keeps setting and resetting them with each
+	// of the operations. Any lost update would leave a bit of another thread changed.
+	void testConcurrentOverlappingWords()
+	{
+		constexpr size_t numOfBits = 4 * sNumOfBitsInWord + 5;
+		constexpr size_t numOfRounds = 2000;
+
+		DB::dynamic_bitset bitset{};
+		bitset.resize(numOfBits);
+		const DB::atomic_bitset_view view(bitset);
+
+		runOnThreads([&view](size_t threadIndex)
+		{
+			std::uint64_t mask{};
+			for (size_t i = threadIndex; i < sNumOfBitsInWord; i += sNumOfThreads)
+			{
+				mask |= std::uint64_t{ 1 } << (sNumOfBitsInWord - 1 - i);
+			}
+
+			for (size_t round = 0; round < numOfRounds; round++)
+			{
+				for (size_t wordIndex = 0; wordIndex < view.num_words(); wordIndex++)
+				{
+					const size_t numOfBitsInWord = std::min(numOfBits - wordIndex * sNumOfBitsInWord, sNumOfBitsInWord);
+					const std::uint64_t wordMask = mask & ~DB::detail::getLowMask(sNumOfBitsInWord - numOfBitsInWord);
+					view.fetch_or_word(wordIndex, wordMask, std::memory_order_relaxed);
+					view.fetch_and_word(wordIndex, ~wordMask, std::memory_order_relaxed);
+				}
+
+				for (size_t bitIndex = threadIndex; bitIndex < numOfBits; bitIndex += sNumOfThreads)
+				{
+					view.test_and_set(bitIndex);
+					if (round + 1 < numOfRounds)
+					{
+						view.test_and_reset(bitIndex);
+					}
+				}
+			}
+		});
+
+		// Every thread left its own bits set.
+		DB_CHECK(view.count() == numOfBits && bitset.count() == numOfBits);
+
+		// Ranges that share their first and last words with the neighbouring ranges.
+		runOnThreads([&view](size_t threadIndex)
+		{
+			const size_t firstBitIndex = threadIndex * numOfBits / sNumOfThreads;
+			const size_t lastBitIndex = (threadIndex + 1) * numOfBits / sNumOfThreads;
+			for (size_t round = 0; round < numOfRounds; round++)
+			{
+				view.reset_range(firstBitIndex, lastBitIndex);
+				if (threadIndex % 2 == 0 || round + 1 < numOfRounds)
+				{
+					view.set_range(firstBitIndex, lastBitIndex);
+				}
+			}
+		});
+
+		// The threads with an odd index left their range reset.
+		size_t numOfSetBits{};
+		for (size_t threadIndex = 0; threadIndex < sNumOfThreads; threadIndex += 2)
+		{
+			numOfSetBits += (threadIndex + 1) * numOfBits / sNumOfThreads - threadIndex * numOfBits / sNumOfThreads;
+		}
+		DB_CHECK(view.count() == numOfSetBits);
+	}
+
+	// Threads allocating slots with set_first_zero get every slot exactly once between them.
+	void testConcurrentSetFirstZero()
+	{
+		constexpr size_t numOfBits = 100000;
+
+		DB::dynamic_bitset bitset{};
+		bitset.resize(numOfBits);
+		const DB::atomic_bitset_view view(bitset);
+		std::vector<std::vector<size_t>> slotsPerThread(sNumOfThreads);
+
+		runOnThreads([&view, &slotsPerThread](size_t threadIndex)
+		{
+			for (size_t slot = view.set_first_zero(0, std::memory_order_acq_rel); slot != DB::atomic_bitset_view::npos; slot = view.set_first_zero(slot, std::memory_order_acq_rel))
+			{
+				slotsPerThread[threadIndex].push_back(slot);
+			}
+		});
+
+		std::vector<size_t> numsOfClaims(numOfBits);
+		for (const std::vector<size_t>& slots : slotsPerThread)
+		{
+			for (const size_t slot : slots)
+			{
+				numsOfClaims[slot]++;
+			}
+		}
+		DB_CHECK(std::all_of(numsOfClaims.begin(), numsOfClaims.end(), [](size_t numOfClaims) { return numOfClaims == 1; }));
+		DB_CHECK(view.count() == numOfBits);
+	}
+}
+
+int main()
+{
+	testOperations();
+	testConcurrentTestAndSet();
+	testConcurrentOverlappingWords();
+	testConcurrentSetFirstZero();
+	return DB::test::sNumOfFailures;
+}
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "Check.h"
+#include "DynamicBitset.h"
+
+// The streams are checked against a dynamic_bitset, whose bytes they must write and read.
+namespace
+{
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	// Collects everything it is passed, and how often it was called.
+	struct VectorSink
+	{
+		void operator()(std::span<const std::byte> bytes)
+		{
+			this->bytes.insert(this->bytes.end(), bytes.begin(), bytes.end());
+			numOfCalls++;
+		}
+
+		std::vector<std::byte> bytes;
+		size_t numOfCalls{};
+	};
+
+	// Returns the bytes of the bitset, the incomplete last byte padded with zeros.
+	std::vector<std::byte> getBytes(DB::dynamic_bitset bitset)
+	{
+		bitset.resize(bitset.size_in_bytes() * DB::sNumOfBitsInByte);
+		std::vector<std::byte> bytes(bitset.size_in_bytes());
+		bitset.extract(reinterpret_cast<char*>(bytes.data()), bytes.size(), 0, 0);
+		return bytes;
+	}
+
+	// Pushes a random mix of bits, bytes, fields and byte arrays, some larger than a chunk, into both the
+	// writer and the bitset.
+	template<typename Writer>
+	void pushBackRandomly(Writer& writer, DB::dynamic_bitset& bitset, size_t numOfPushBacks)
+	{
+		for (size_t i = 0; i < numOfPushBacks; i++)
+		{
+			switch (sRandom() % 6)
+			{
+			case 0:
+			{
+				const DB::bit bit = (sRandom() & 1) != 0;
+				writer.push_back(bit);
+				bitset.push_back(bit);
+				break;
+			}
+			case 1:
+			{
+				const DB::byte byte{ static_cast<unsigned char>(sRandom()) };
+				writer.push_back(byte);
+				bitset.push_back(byte);
+				break;
+			}
+			case 2:
+			{
+				const std::uint64_t value = sRandom();
+				const unsigned numOfBits = static_cast<unsigned>(sRandom() % (DB::detail::sNumOfBitsInWord + 1));
+				writer.write_bits(value, numOfBits);
+				bitset.write_bits(value, numOfBits);
+				break;
+			}
+			case 3:
+			{
+				const std::uint32_t value = static_cast<std::uint32_t>(sRandom());
+				writer.push_back(value);
+				bitset.push_back(value);
+				break;
+			}
+			case 4:
+			{
+				std::string bytes(sRandom() % 300, '\0');
+				for (char& byte : bytes)
+				{
+					byte = static_cast<char>(sRandom());
+				}
+				writer.push_back(bytes.data(), bytes.size());
+				bitset.push_back(bytes.data(), bytes.size());
+				break;
+			}
+			default:
+				writer.flush();
+				break;
+			}
+			DB_CHECK(writer.size() == bitset.size());
+		}
+	}
+
+	// Whatever the chunk size, and however the bits are pushed back, the sink ends up with the bytes of the
+	// bitset.
+	void testWriter()
+	{
+		for (const size_t chunkSizeInBytes : { 1, 3, 8, 64, 1000 })
+		{
+			DB::bit_writer<VectorSink> writer(VectorSink{}, chunkSizeInBytes);
+			DB::dynamic_bitset bitset{};
+
+			pushBackRandomly(writer, bitset, 2000);
+			DB_CHECK(writer.sink().bytes.size() <= bitset.size() / DB::sNumOfBitsInByte);
+			DB_CHECK(writer.finish() == bitset.size());
+			DB_CHECK(writer.sink().bytes == getBytes(bitset));
+
+			// After finishing, the writer continues at the next whole byte.
+			bitset.resize(bitset.size_in_bytes() * DB::sNumOfBitsInByte);
+			pushBackRandomly(writer, bitset, 100);
+			writer.finish();
+			DB_CHECK(writer.sink().bytes == getBytes(bitset));
+		}
+
+		// Without flushes, only complete chunks reach the sink before finishing.
+		DB::bit_writer<VectorSink> writer(VectorSink{}, 4);
+		for (size_t i = 0; i < 12 * DB::sNumOfBitsInByte - 1; i++)
+		{
+			writer.push_back(DB::bit{ true });
+		}
+		DB_CHECK(writer.sink().numOfCalls == 2 && writer.sink().bytes.size() == 8);
+		DB_CHECK(writer.finish() == 12 * DB::sNumOfBitsInByte - 1);
+		DB_CHECK(writer.sink().bytes.size() == 12 && writer.sink().bytes.back() == std::byte{ 0xFE });
+	}
+
+	// A stream sink writes the same bytes into the stream.
+	void testStreamSink()
+	{
+		std::ostringstream stream{};
+		DB::bit_writer writer(DB::stream_sink(stream), 16);
+		DB::dynamic_bitset bitset{};
+
+		pushBackRandomly(writer, bitset, 500);
+		writer.finish();
+
+		const std::string written = stream.str();
+		const std::vector<std::byte> bytes = getBytes(bitset);
+		DB_CHECK(written.size() == bytes.size() && std::memcmp(written.data(), bytes.data(), bytes.size()) == 0);
+	}
+
+	// Hands out the bytes a random number of them at a time, up to a maximum, like a pipe or socket would.
+	struct PieceSource
+	{
+		size_t operator()(std::span<std::byte> destination)
+		{
+			const size_t numOfBytes = std::min({ destination.size(), bytes.size() - position, 1 + static_cast<size_t>(sRandom() % maxNumOfBytes) });
+			std::memcpy(destination.data(), bytes.data() + position, numOfBytes);
+			position += numOfBytes;
+			return numOfBytes;
+		}
+
+		std::vector<std::byte> bytes;
+		size_t maxNumOfBytes;
+		size_t position{};
+	};
+
+	DB::dynamic_bitset makeRandomBitset(size_t numOfBytes)
+	{
+		DB::dynamic_bitset bitset{};
+		for (size_t i = 0; i < numOfBytes; i++)
+		{
+			bitset.push_back(DB::byte{ static_cast<unsigned char>(sRandom()) });
+		}
+		return bitset;
+	}
+
+	// Reads random mixes of bits, fields, values and byte arrays, which cross the ends of the words and
+	// of the buffer at every offset, and compares them with reading the bitset through an iterator.
+	void testReader()
+	{
+		for (const size_t bufferSizeInBytes : { 8, 9, 16, 64, 1000 })
+		{
+			for (const size_t maxNumOfBytesPerRead : { 1, 3, 7, 4096 })
+			{
+				DB::dynamic_bitset bitset = makeRandomBitset(20000);
+				DB::bit_reader<PieceSource> reader(PieceSource{ getBytes(bitset), maxNumOfBytesPerRead }, bufferSizeInBytes);
+				DB::dynamic_bitset::iterator it = bitset.begin();
+
+				while (!reader.at_end())
+				{
+					const size_t numOfBitsLeft = static_cast<size_t>(bitset.end() - it);
+					switch (sRandom() % 5)
+					{
+					case 0:
+						DB_CHECK(reader.read_bit() == static_cast<DB::bit>(*it++));
+						break;
+					case 1:
+					{
+						const unsigned numOfBits = static_cast<unsigned>(sRandom() % (std::min(numOfBitsLeft, DB::detail::sNumOfBitsInWord) + 1));
+						DB_CHECK(reader.read_bits(numOfBits) == DB::dynamic_bitset::read_bits(it, numOfBits));
+						break;
+					}
+					case 2:
+						if (numOfBitsLeft >= 32)
+						{
+							DB_CHECK(reader.extract<std::uint32_t>() == DB::dynamic_bitset::extract<std::uint32_t>(it));
+						}
+						break;
+					default:
+					{
+						// Up to more than a buffer, so that some go straight from the source.
+						const size_t numOfBytes = sRandom() % (std::min(numOfBitsLeft / DB::sNumOfBitsInByte, 2 * bufferSizeInBytes) + 1);
+						std::string bytes(numOfBytes, '\0');
+						std::string expectedBytes(numOfBytes, '\0');
+						reader.extract(bytes.data(), bytes.size());
+						DB::dynamic_bitset::extract(expectedBytes.data(), expectedBytes.size(), it);
+						DB_CHECK(bytes == expectedBytes);
+						break;
+					}
+					}
+					DB_CHECK(reader.position() == static_cast<size_t>(it - bitset.begin()));
+				}
+				DB_CHECK(it == bitset.end());
+			}
+		}
+	}
+
+	template<typename Function>
+	bool throwsOutOfRange(Function&& function)
+	{
+		try
+		{
+			function();
+		}
+		catch (const std::out_of_range&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	// Reading more than what is left throws, whether the bits are cached, buffered or still in the source.
+	void testReadPastEnd()
+	{
+		const DB::dynamic_bitset bitset = makeRandomBitset(100);
+		const auto makeReader = [&bitset]() { return DB::bit_reader<PieceSource>(PieceSource{ getBytes(bitset), 3 }, 16); };
+
+		for (size_t numOfBitsToSkip : { size_t{ 0 }, size_t{ 5 }, size_t{ 64 }, size_t{ 797 }, size_t{ 800 } })
+		{
+			const size_t numOfBitsLeft = bitset.size() - numOfBitsToSkip;
+
+			auto reader = makeReader();
+			for (size_t i = 0; i < numOfBitsToSkip; i++)
+			{
+				reader.read_bit();
+			}
+			DB_CHECK(reader.at_end() == (numOfBitsLeft == 0));
+			DB_CHECK(numOfBitsLeft > 0 || throwsOutOfRange([&reader]() { reader.read_bit(); }));
+			DB_CHECK(numOfBitsLeft >= 64 || throwsOutOfRange([&reader, numOfBitsLeft]() { reader.read_bits(static_cast<unsigned>(numOfBitsLeft + 1)); }));
+
+			reader = makeReader();
+			reader.read_bits(static_cast<unsigned>(numOfBitsToSkip % DB::sNumOfBitsInByte));
+			std::string bytes(numOfBitsToSkip / DB::sNumOfBitsInByte, '\0');
+			reader.extract(bytes.data(), bytes.size());
+			std::string rest(numOfBitsLeft / DB::sNumOfBitsInByte + 1, '\0');
+			DB_CHECK(throwsOutOfRange([&reader, &rest]() { reader.extract(rest.data(), rest.size()); }));
+		}
+	}
+
+	// A stream source reads the same bits as the bitset has.
+	void testStreamSource()
+	{
+		const DB::dynamic_bitset bitset = makeRandomBitset(1000);
+		const std::vector<std::byte> bytes = getBytes(bitset);
+		std::istringstream stream(std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+		DB::bit_reader reader(DB::stream_source(stream), 64);
+
+		for (size_t i = 0; i < bitset.size(); i++)
+		{
+			DB_CHECK(reader.read_bit() == bitset.get(i / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(i % DB::sNumOfBitsInByte)));
+		}
+		DB_CHECK(reader.at_end());
+	}
+}
+
+int main()
+{
+	testWriter();
+	testStreamSink();
+	testReader();
+	testReadPastEnd();
+	testStreamSource();
+	return DB::test::sNumOfFailures;
+}
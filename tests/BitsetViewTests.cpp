@@ -0,0 +1,102 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // __unix__ || __APPLE__
+
+#include "BitsetView.h"
+#include "Check.h"
+
+namespace
+{
+	// Counts every range of a bitset through a view of its blocks, against counting the bits one by one.
+	template<typename Block>
+	void testCountRange()
+	{
+		std::mt19937 random(7);
+		DB::basic_dynamic_bitset<Block> bitset{};
+		std::vector<bool> bits{};
+		for (size_t i = 0; i < 300; i++)
+		{
+			const bool value = random() % 3 == 0;
+			bitset.push_back(static_cast<DB::bit>(value));
+			bits.push_back(value);
+		}
+
+		const DB::basic_bitset_view<Block> view(bitset.data(), bitset.size());
+		DB_CHECK(view.count() == bitset.count());
+
+		for (size_t first = 0; first <= bits.size(); first += 7)
+		{
+			size_t numOfSetBits{};
+			for (size_t last = first; last <= bits.size(); last++)
+			{
+				DB_CHECK(view.count(view.begin() + static_cast<std::ptrdiff_t>(first), view.begin() + static_cast<std::ptrdiff_t>(last)) == numOfSetBits);
+				numOfSetBits += last < bits.size() && bits[last];
+			}
+		}
+	}
+
+	// A view of a bitset deduces the bitset's block type and has the same bits.
+	void testViewOfBitset()
+	{
+		DB::dynamic_bitset bitset{};
+		bitset.push_back(std::uint64_t{ 0x0123456789ABCDEF });
+		bitset.write_bits(0b101, 3);
+
+		const DB::basic_bitset_view view(bitset);
+		static_assert(std::is_same_v<decltype(view), const DB::basic_bitset_view<std::uint64_t>>);
+		DB_CHECK(view.size() == bitset.size());
+		DB_CHECK(view.count() == bitset.count());
+
+		DB::basic_bitset_view<std::uint64_t>::const_iterator it = view.begin();
+		DB_CHECK(view.extract<std::uint64_t>(it) == 0x0123456789ABCDEF);
+		DB_CHECK(view.read_bits(it, 3) == 0b101);
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	// Counting a range must not read the blocks before it, which would load every page of a mapped file
+	// up to the range. The page before the range is made unreadable, so reading it crashes the test.
+	void testCountRangeOnlyReadsRange()
+	{
+		const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		void* pages = mmap(nullptr, 2 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		DB_CHECK(pages != MAP_FAILED);
+		if (pages == MAP_FAILED)
+		{
+			return;
+		}
+
+		unsigned char* bytes = static_cast<unsigned char*>(pages);
+		for (size_t i = pageSize; i < 2 * pageSize; i++)
+		{
+			bytes[i] = 0x81;
+		}
+		mprotect(pages, pageSize, PROT_NONE);
+
+		const DB::bitset_view view(bytes, 2 * pageSize * DB::sNumOfBitsInByte);
+		const DB::bitset_view::const_iterator first = view.begin() + static_cast<std::ptrdiff_t>(pageSize * DB::sNumOfBitsInByte);
+		DB_CHECK(view.count(first, view.end()) == 2 * pageSize);
+		DB_CHECK(view.count(first + 1, view.end() - 1) == 2 * pageSize - 2);
+
+		munmap(pages, 2 * pageSize);
+	}
+#endif // __unix__ || __APPLE__
+}
+
+int main()
+{
+	testCountRange<unsigned char>();
+	testCountRange<std::uint16_t>();
+	testCountRange<std::uint64_t>();
+	testViewOfBitset();
+#if defined(__unix__) || defined(__APPLE__)
+	testCountRangeOnlyReadsRange();
+#endif // __unix__ || __APPLE__
+	return DB::test::sNumOfFailures;
+}
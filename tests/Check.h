@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+
+// A minimal check for the tests, which keeps going after a failure so that one run reports every
+// failing check. The tests return the number of failures from main, which ctest reports as failed.
+namespace DB::test
+{
+	inline int sNumOfFailures = 0;
+
+	inline void check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+			sNumOfFailures++;
+		}
+	}
+}
+
+#define DB_CHECK(...) ::DB::test::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
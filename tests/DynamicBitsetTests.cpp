@@ -0,0 +1,541 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "DynamicBitset.h"
+
+// Most of these tests are differential: random bits are appended to a bitset and to a std::vector<bool>,
+// and whatever the bitset's kernels return is compared against the obvious loop over the vector. They
+// run for every type of block, starting at every offset within a couple of blocks and for lengths of up
+// to a few blocks, so that the partial first and last blocks are all covered.
+namespace
+{
+	using Reference = std::vector<bool>;
+
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	// Each bit is set with the probability of the density.
+	Reference makeRandomReference(size_t numOfBits, double density = 0.5)
+	{
+		std::bernoulli_distribution distribution(density);
+		Reference reference{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			reference.push_back(distribution(sRandom));
+		}
+		return reference;
+	}
+
+	std::vector<unsigned char> makeRandomBytes(size_t numOfBytes)
+	{
+		std::vector<unsigned char> bytes(numOfBytes);
+		for (unsigned char& byte : bytes)
+		{
+			byte = static_cast<unsigned char>(sRandom());
+		}
+		return bytes;
+	}
+
+	// Appends the bits of the bytes in the order of byte::get, the most significant bit first.
+	void appendBytes(Reference& reference, const unsigned char* bytes, size_t numOfBytes)
+	{
+		for (size_t i = 0; i < numOfBytes; i++)
+		{
+			for (size_t j = 0; j < DB::sNumOfBitsInByte; j++)
+			{
+				reference.push_back(((bytes[i] >> (DB::sNumOfBitsInByte - 1 - j)) & 1) != 0);
+			}
+		}
+	}
+
+	template<typename Bitset>
+	Bitset makeBitset(const Reference& reference)
+	{
+		Bitset bitset{};
+		for (const bool bit : reference)
+		{
+			bitset.push_back(static_cast<DB::bit>(bit));
+		}
+		return bitset;
+	}
+
+	template<typename Bitset>
+	DB::bit getBit(const Bitset& bitset, size_t bitIndex)
+	{
+		return bitset.get(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte));
+	}
+
+	// Compares every bit, and checks that the bits past the end are zero as the kernels rely on that.
+	template<typename Bitset>
+	bool isSame(const Bitset& bitset, const Reference& reference)
+	{
+		if (bitset.size() != reference.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < reference.size(); i++)
+		{
+			if (getBit(bitset, i) != reference[i])
+			{
+				return false;
+			}
+		}
+
+		using Block = typename Bitset::block_type;
+		const size_t numOfBitsInLastBlock = bitset.size() % DB::sNumOfBitsInType<Block>;
+		return numOfBitsInLastBlock == 0 || static_cast<Block>(bitset.data()[bitset.num_words() - 1] << numOfBitsInLastBlock) == 0;
+	}
+
+	// The offsets are every bit within the first two blocks, and the lengths are up to three blocks and
+	// past a few 64 byte vectors, for the SIMD kernels.
+	template<typename Block>
+	constexpr size_t sMaxNumOfOffsetBits = 2 * DB::sNumOfBitsInType<Block> + 1;
+
+	template<typename Block>
+	std::vector<size_t> getNumsOfBytes()
+	{
+		std::vector<size_t> numsOfBytes{};
+		for (size_t i = 0; i <= 3 * sizeof(Block); i++)
+		{
+			numsOfBytes.push_back(i);
+		}
+		for (const size_t numOfBytes : { 31, 32, 33, 63, 64, 65, 127, 200 })
+		{
+			numsOfBytes.push_back(numOfBytes);
+		}
+		return numsOfBytes;
+	}
+
+	// DB::bit_ref is the reference type of dynamic_bitset, whatever its blocks are.
+	void testBitRef()
+	{
+		static_assert(std::is_same_v<DB::bit_ref, DB::dynamic_bitset::bit_reference>);
+		static_assert(std::is_same_v<DB::bit_ref, DB::dynamic_bitset::iterator::reference>);
+
+		DB::dynamic_bitset bitset{};
+		bitset.resize(12);
+		DB::bit_ref first = bitset.getBitRef(0, 0);
+		first = true;
+		DB::bit_ref last = *(bitset.begin() + 11);
+		last = true;
+		DB_CHECK(bitset.get(0, 0) && bitset.get(1, 3) && bitset.count() == 2);
+
+		DB::byte byte{};
+		DB::byte_bit_ref bitOfByte = byte.getBitRef(1);
+		bitOfByte = true;
+		DB_CHECK(static_cast<unsigned char>(byte) == 0x40);
+	}
+
+	// Appending bytes and trivially copyable values at any offset lands their bits right after the
+	// existing ones, in memory order.
+	template<typename Block>
+	void testPushBackBytes()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		for (size_t numOfOffsetBits = 0; numOfOffsetBits < sMaxNumOfOffsetBits<Block>; numOfOffsetBits++)
+		{
+			for (const size_t numOfBytes : getNumsOfBytes<Block>())
+			{
+				Reference reference = makeRandomReference(numOfOffsetBits);
+				Bitset bitset = makeBitset<Bitset>(reference);
+				const std::vector<unsigned char> bytes = makeRandomBytes(numOfBytes);
+
+				bitset.push_back(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+				appendBytes(reference, bytes.data(), bytes.size());
+				DB_CHECK(isSame(bitset, reference));
+			}
+
+			Reference reference = makeRandomReference(numOfOffsetBits);
+			Bitset bitset = makeBitset<Bitset>(reference);
+
+			const std::uint64_t value = sRandom();
+			const std::array<unsigned char, 7> array{ 1, 2, 3, 4, 5, 6, 7 };
+			const DB::byte byte{ static_cast<unsigned char>(sRandom()) };
+			bitset.push_back(value);
+			bitset.push_back(array);
+			bitset.push_back(byte);
+			appendBytes(reference, reinterpret_cast<const unsigned char*>(&value), sizeof(value));
+			appendBytes(reference, array.data(), array.size());
+			const unsigned char byteValue = static_cast<unsigned char>(byte);
+			appendBytes(reference, &byteValue, 1);
+			DB_CHECK(isSame(bitset, reference));
+		}
+	}
+
+	// Extracting at any offset returns the bytes whose bits follow the offset, also when they end in the
+	// last, incomplete block, and advances the iterator past them.
+	template<typename Block>
+	void testExtractBytes()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		for (size_t numOfOffsetBits = 0; numOfOffsetBits < sMaxNumOfOffsetBits<Block>; numOfOffsetBits++)
+		{
+			for (const size_t numOfBytes : getNumsOfBytes<Block>())
+			{
+				for (const size_t numOfTrailingBits : { size_t{ 0 }, size_t{ 5 } })
+				{
+					const Reference reference = makeRandomReference(numOfOffsetBits + numOfBytes * DB::sNumOfBitsInByte + numOfTrailingBits);
+					Bitset bitset = makeBitset<Bitset>(reference);
+
+					std::vector<unsigned char> bytes(numOfBytes);
+					typename Bitset::iterator it = bitset.begin() + numOfOffsetBits;
+					Bitset::extract(reinterpret_cast<char*>(bytes.data()), bytes.size(), it);
+					DB_CHECK(it == bitset.begin() + (numOfOffsetBits + numOfBytes * DB::sNumOfBitsInByte));
+
+					Reference extracted(reference.begin(), reference.begin() + static_cast<std::ptrdiff_t>(numOfOffsetBits));
+					appendBytes(extracted, bytes.data(), bytes.size());
+					extracted.insert(extracted.end(), reference.end() - static_cast<std::ptrdiff_t>(numOfTrailingBits), reference.end());
+					DB_CHECK(extracted == reference);
+				}
+			}
+
+			Reference reference = makeRandomReference(numOfOffsetBits);
+			const std::uint64_t value = sRandom();
+			const std::array<unsigned char, 7> array{ 1, 2, 3, 4, 5, 6, 7 };
+			appendBytes(reference, reinterpret_cast<const unsigned char*>(&value), sizeof(value));
+			appendBytes(reference, array.data(), array.size());
+			Bitset bitset = makeBitset<Bitset>(reference);
+
+			DB_CHECK(bitset.template extract<std::uint64_t>(numOfOffsetBits / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(numOfOffsetBits % DB::sNumOfBitsInByte)) == value);
+			typename Bitset::iterator it = bitset.begin() + (numOfOffsetBits + sizeof(value) * DB::sNumOfBitsInByte);
+			DB_CHECK((Bitset::template extract<std::array<unsigned char, 7>>(it) == array));
+			DB_CHECK(it == bitset.end());
+		}
+	}
+
+	// Fields of every width from 0 to 64 bits are written after any offset, keeping only their least
+	// significant bits, and read back with the same widths.
+	template<typename Block>
+	void testWriteAndReadBits()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		for (size_t numOfOffsetBits = 0; numOfOffsetBits < sMaxNumOfOffsetBits<Block>; numOfOffsetBits++)
+		{
+			Reference reference = makeRandomReference(numOfOffsetBits);
+			Bitset bitset = makeBitset<Bitset>(reference);
+
+			std::vector<std::pair<std::uint64_t, unsigned>> fields{};
+			for (unsigned numOfBits = 0; numOfBits <= DB::detail::sNumOfBitsInWord; numOfBits++)
+			{
+				const std::uint64_t value = sRandom();
+				bitset.write_bits(value, numOfBits);
+				for (unsigned i = numOfBits; i > 0; i--)
+				{
+					reference.push_back(((value >> (i - 1)) & 1) != 0);
+				}
+				fields.emplace_back(value & DB::detail::getLowMask(numOfBits), numOfBits);
+			}
+			DB_CHECK(isSame(bitset, reference));
+
+			typename Bitset::iterator it = bitset.begin() + numOfOffsetBits;
+			for (const auto& [value, numOfBits] : fields)
+			{
+				DB_CHECK(Bitset::read_bits(it, numOfBits) == value);
+			}
+			DB_CHECK(it == bitset.end());
+		}
+	}
+
+	// Counting the whole bitset, a range starting at any offset and every rank matches counting the bits
+	// of the reference one by one, for empty, sparse, dense and full bitsets.
+	template<typename Block>
+	void testCount()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		const std::vector<size_t> numsOfBytes = getNumsOfBytes<Block>();
+		const size_t maxNumOfBits = sMaxNumOfOffsetBits<Block> + numsOfBytes.back() * DB::sNumOfBitsInByte + DB::sNumOfBitsInByte;
+
+		for (const double density : { 0.0, 0.01, 0.5, 0.99, 1.0 })
+		{
+			const Reference reference = makeRandomReference(maxNumOfBits, density);
+			const Bitset bitset = makeBitset<Bitset>(reference);
+
+			std::vector<size_t> ranks{ 0 };
+			for (const bool bit : reference)
+			{
+				ranks.push_back(ranks.back() + bit);
+			}
+
+			DB_CHECK(bitset.count() == ranks.back());
+			for (size_t i = 0; i <= reference.size(); i++)
+			{
+				DB_CHECK(bitset.rank(i) == ranks[i]);
+			}
+
+			for (size_t numOfOffsetBits = 0; numOfOffsetBits < sMaxNumOfOffsetBits<Block>; numOfOffsetBits++)
+			{
+				for (const size_t numOfBytes : numsOfBytes)
+				{
+					// Ends at an offset different from the one it starts at.
+					const size_t lastBitIndex = numOfOffsetBits + numOfBytes * DB::sNumOfBitsInByte + numOfOffsetBits % DB::sNumOfBitsInByte;
+					DB_CHECK(bitset.count(bitset.begin() + numOfOffsetBits, bitset.begin() + lastBitIndex) == ranks[lastBitIndex] - ranks[numOfOffsetBits]);
+
+					const Bitset prefix = makeBitset<Bitset>(Reference(reference.begin(), reference.begin() + static_cast<std::ptrdiff_t>(lastBitIndex)));
+					DB_CHECK(prefix.count() == ranks[lastBitIndex]);
+				}
+			}
+		}
+	}
+
+	// Applies the operation bit by bit, keeping the size of the left hand side and treating the bits the
+	// right hand side doesn't have as zero.
+	template<typename Operation>
+	Reference combine(const Reference& lhs, const Reference& rhs, Operation&& operation)
+	{
+		Reference result{};
+		for (size_t i = 0; i < lhs.size(); i++)
+		{
+			result.push_back(operation(lhs[i], i < rhs.size() && rhs[i]));
+		}
+		return result;
+	}
+
+	// The bitwise operators match the bit by bit operations for every combination of sizes, which are
+	// around the ends of blocks and long enough for the SIMD kernels.
+	template<typename Block>
+	void testBitwiseOperators()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		constexpr size_t numOfBitsInBlock = DB::sNumOfBitsInType<Block>;
+		const std::vector<size_t> numsOfBits{ 0, 1, numOfBitsInBlock - 1, numOfBitsInBlock, numOfBitsInBlock + 1,
+			3 * numOfBitsInBlock, 3 * numOfBitsInBlock + 5, 1000, 1601 };
+
+		for (const size_t numOfBits : numsOfBits)
+		{
+			for (const size_t numOfOtherBits : numsOfBits)
+			{
+				const Reference lhs = makeRandomReference(numOfBits);
+				const Reference rhs = makeRandomReference(numOfOtherBits);
+				const Bitset lhsBitset = makeBitset<Bitset>(lhs);
+				const Bitset rhsBitset = makeBitset<Bitset>(rhs);
+
+				DB_CHECK(isSame(lhsBitset & rhsBitset, combine(lhs, rhs, [](bool a, bool b) { return a && b; })));
+				DB_CHECK(isSame(lhsBitset | rhsBitset, combine(lhs, rhs, [](bool a, bool b) { return a || b; })));
+				DB_CHECK(isSame(lhsBitset ^ rhsBitset, combine(lhs, rhs, [](bool a, bool b) { return a != b; })));
+				DB_CHECK(isSame(andnot(lhsBitset, rhsBitset), combine(lhs, rhs, [](bool a, bool b) { return a && !b; })));
+
+				Bitset bitset = lhsBitset;
+				bitset |= rhsBitset;
+				bitset &= lhsBitset;
+				DB_CHECK(isSame(bitset, lhs));
+			}
+
+			const Reference reference = makeRandomReference(numOfBits);
+			DB_CHECK(isSame(~makeBitset<Bitset>(reference), combine(reference, {}, [](bool a, bool) { return !a; })));
+		}
+	}
+
+	// Returns the index of the first bit at or after bitIndex that has the value, or npos.
+	size_t findNext(const Reference& reference, size_t bitIndex, bool value)
+	{
+		for (; bitIndex < reference.size(); bitIndex++)
+		{
+			if (reference[bitIndex] == value)
+			{
+				return bitIndex;
+			}
+		}
+		return DB::detail::sNotFound;
+	}
+
+	// The find functions and for_each_set_bit visit the same bits as a scan of the reference, from every
+	// bit, for sizes around the ends of blocks and densities from empty to full.
+	template<typename Block>
+	void testFind()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		constexpr size_t numOfBitsInBlock = DB::sNumOfBitsInType<Block>;
+		constexpr size_t npos = Bitset::npos;
+
+		for (const size_t numOfBits : { size_t{ 0 }, size_t{ 1 }, numOfBitsInBlock - 1, numOfBitsInBlock, numOfBitsInBlock + 1, 3 * numOfBitsInBlock + 5, size_t{ 1000 } })
+		{
+			for (const double density : { 0.0, 0.01, 0.5, 0.99, 1.0 })
+			{
+				const Reference reference = makeRandomReference(numOfBits, density);
+				const Bitset bitset = makeBitset<Bitset>(reference);
+
+				DB_CHECK(bitset.find_first() == findNext(reference, 0, true));
+				DB_CHECK(bitset.find_first_zero() == findNext(reference, 0, false));
+				DB_CHECK(bitset.find_next(npos) == npos && bitset.find_next_zero(npos) == npos);
+
+				size_t previousSetBitIndex = npos;
+				for (size_t i = 0; i < numOfBits; i++)
+				{
+					DB_CHECK(bitset.find_next(i) == findNext(reference, i + 1, true));
+					DB_CHECK(bitset.find_next_zero(i) == findNext(reference, i + 1, false));
+					DB_CHECK(bitset.find_prev(i) == previousSetBitIndex);
+					previousSetBitIndex = reference[i] ? i : previousSetBitIndex;
+				}
+				DB_CHECK(bitset.find_prev(numOfBits) == previousSetBitIndex && bitset.find_prev(npos) == previousSetBitIndex);
+
+				std::vector<size_t> setBitIndices{};
+				bitset.for_each_set_bit([&setBitIndices](size_t bitIndex) { setBitIndices.push_back(bitIndex); });
+
+				std::vector<size_t> expectedSetBitIndices{};
+				for (size_t i = findNext(reference, 0, true); i != npos; i = findNext(reference, i + 1, true))
+				{
+					expectedSetBitIndices.push_back(i);
+				}
+				DB_CHECK(setBitIndices == expectedSetBitIndices);
+			}
+		}
+	}
+
+	// Moving the iterators by any offset, in any way, lands on the same bit as indexing the reference, and
+	// the standard algorithms can binary search them.
+	template<typename Block>
+	void testIterators()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		static_assert(std::random_access_iterator<typename Bitset::iterator>);
+		static_assert(std::random_access_iterator<typename Bitset::const_iterator>);
+
+		const size_t numOfBits = 3 * DB::sNumOfBitsInType<Block> + 5;
+		const Reference reference = makeRandomReference(numOfBits);
+		Bitset bitset = makeBitset<Bitset>(reference);
+		const Bitset& constBitset = bitset;
+
+		DB_CHECK(std::distance(bitset.begin(), bitset.end()) == static_cast<std::ptrdiff_t>(numOfBits));
+		DB_CHECK(constBitset.end() - constBitset.begin() == static_cast<std::ptrdiff_t>(numOfBits));
+
+		for (std::ptrdiff_t i = 0; i <= static_cast<std::ptrdiff_t>(numOfBits); i++)
+		{
+			for (std::ptrdiff_t j = 0; j <= static_cast<std::ptrdiff_t>(numOfBits); j++)
+			{
+				typename Bitset::iterator it = bitset.begin() + i;
+				it += j - i;
+				DB_CHECK(it == bitset.begin() + j && it - (j - i) == bitset.begin() + i);
+				DB_CHECK(it - (bitset.begin() + i) == j - i);
+				DB_CHECK(((bitset.begin() + i) < it) == (i < j) && ((bitset.begin() + i) <=> it) == (i <=> j));
+
+				typename Bitset::const_iterator constIt = constBitset.end();
+				constIt -= static_cast<std::ptrdiff_t>(numOfBits) - j;
+				DB_CHECK(constIt == std::next(constBitset.begin(), j));
+
+				if (j < static_cast<std::ptrdiff_t>(numOfBits))
+				{
+					DB_CHECK(static_cast<bool>((bitset.begin() + i)[j - i]) == reference[static_cast<size_t>(j)]);
+					DB_CHECK(*constIt == reference[static_cast<size_t>(j)]);
+				}
+			}
+		}
+
+		typename Bitset::iterator it = bitset.end();
+		for (size_t i = numOfBits; i > 0; i--)
+		{
+			DB_CHECK(static_cast<bool>(*--it) == reference[i - 1]);
+		}
+		DB_CHECK(it == bitset.begin() && it++ == bitset.begin() && it-- == bitset.begin() + 1 && it == bitset.begin());
+
+		// A sorted bitset, the unset bits first, is binary searched for its first set bit.
+		for (size_t numOfUnsetBits = 0; numOfUnsetBits <= numOfBits; numOfUnsetBits++)
+		{
+			Bitset sorted{};
+			sorted.resize(numOfUnsetBits);
+			sorted.resize(numOfBits, true);
+			const Bitset& constSorted = sorted;
+			DB_CHECK(std::lower_bound(constSorted.begin(), constSorted.end(), true) - constSorted.begin() == static_cast<std::ptrdiff_t>(numOfUnsetBits));
+		}
+	}
+
+	// A random sequence of resizes, appends and removals keeps the same bits as the reference, and
+	// reserving or shrinking the capacity never changes them.
+	template<typename Block>
+	void testResizeAndCapacity()
+	{
+		using Bitset = DB::basic_dynamic_bitset<Block>;
+
+		constexpr size_t maxNumOfBits = 3 * DB::sNumOfBitsInType<Block> + 5;
+
+		Reference reference{};
+		Bitset bitset{};
+
+		for (size_t i = 0; i < 2000; i++)
+		{
+			switch (sRandom() % 5)
+			{
+			case 0:
+			{
+				const size_t numOfBits = sRandom() % (maxNumOfBits + 1);
+				const bool value = (sRandom() & 1) != 0;
+				bitset.resize(numOfBits, value);
+				reference.resize(numOfBits, value);
+				break;
+			}
+			case 1:
+			{
+				const bool value = (sRandom() & 1) != 0;
+				bitset.push_back(static_cast<DB::bit>(value));
+				reference.push_back(value);
+				break;
+			}
+			case 2:
+				if (!reference.empty())
+				{
+					bitset.pop_back();
+					reference.pop_back();
+				}
+				break;
+			case 3:
+			{
+				const size_t numOfBits = sRandom() % (2 * maxNumOfBits);
+				bitset.reserve(numOfBits);
+				DB_CHECK(bitset.capacity() >= numOfBits);
+				break;
+			}
+			default:
+				bitset.shrink_to_fit();
+				break;
+			}
+
+			DB_CHECK(isSame(bitset, reference));
+			DB_CHECK(bitset.capacity() >= bitset.size() && bitset.empty() == reference.empty());
+			DB_CHECK(bitset.num_words() == DB::detail::getNumOfBlocksNeeded<Block>(bitset.size()));
+		}
+
+		// Appending up to the reserved capacity doesn't reallocate.
+		bitset.clear();
+		bitset.reserve(maxNumOfBits);
+		const Block* const blocks = bitset.data();
+		bitset.resize(maxNumOfBits, true);
+		DB_CHECK(bitset.data() == blocks && bitset.count() == maxNumOfBits);
+	}
+
+	template<typename Block>
+	void testBlock()
+	{
+		testPushBackBytes<Block>();
+		testExtractBytes<Block>();
+		testWriteAndReadBits<Block>();
+		testCount<Block>();
+		testBitwiseOperators<Block>();
+		testFind<Block>();
+		testIterators<Block>();
+		testResizeAndCapacity<Block>();
+	}
+}
+
+int main()
+{
+	testBitRef();
+	testBlock<std::uint8_t>();
+	testBlock<std::uint16_t>();
+	testBlock<std::uint32_t>();
+	testBlock<std::uint64_t>();
+	return DB::test::sNumOfFailures;
+}
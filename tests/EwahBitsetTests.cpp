@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "DynamicBitset.h"
+#include "EwahBitset.h"
+
+// The compressed bitsets are checked against a dynamic_bitset with the same bits appended.
+namespace
+{
+	constexpr size_t sNumOfBitsInWord = DB::detail::sNumOfBitsInWord;
+
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	// Appends a random mix of single bits, bytes, fields and runs to both, so that there are fills of
+	// zeros and ones, literals, and incomplete last words.
+	void appendRandomly(DB::ewah_bitset& ewah, DB::dynamic_bitset& bitset, size_t numOfAppends)
+	{
+		for (size_t i = 0; i < numOfAppends; i++)
+		{
+			switch (sRandom() % 4)
+			{
+			case 0:
+			{
+				const DB::bit bit = (sRandom() & 1) != 0;
+				ewah.push_back(bit);
+				bitset.push_back(bit);
+				break;
+			}
+			case 1:
+			{
+				const DB::byte byte{ static_cast<unsigned char>(sRandom()) };
+				ewah.push_back(byte);
+				bitset.push_back(byte);
+				break;
+			}
+			case 2:
+			{
+				const std::uint64_t value = sRandom();
+				const unsigned numOfBits = static_cast<unsigned>(sRandom() % (sNumOfBitsInWord + 1));
+				ewah.write_bits(value, numOfBits);
+				bitset.write_bits(value, numOfBits);
+				break;
+			}
+			default:
+			{
+				const DB::bit value = (sRandom() & 1) != 0;
+				const size_t numOfBits = sRandom() % (10 * sNumOfBitsInWord);
+				ewah.push_back(value, numOfBits);
+				bitset.resize(bitset.size() + numOfBits, value);
+				break;
+			}
+			}
+		}
+	}
+
+	std::vector<size_t> getSetBitIndices(const DB::dynamic_bitset& bitset)
+	{
+		std::vector<size_t> setBitIndices{};
+		bitset.for_each_set_bit([&setBitIndices](size_t bitIndex) { setBitIndices.push_back(bitIndex); });
+		return setBitIndices;
+	}
+
+	bool isSame(const DB::dynamic_bitset& lhs, const DB::dynamic_bitset& rhs)
+	{
+		return lhs.size() == rhs.size() && std::equal(lhs.data(), lhs.data() + lhs.num_words(), rhs.data(), rhs.data() + rhs.num_words());
+	}
+
+	bool isSame(const DB::ewah_bitset& ewah, const DB::dynamic_bitset& bitset)
+	{
+		std::vector<size_t> setBitIndices{};
+		ewah.for_each_set_bit([&setBitIndices](size_t bitIndex) { setBitIndices.push_back(bitIndex); });
+
+		std::vector<DB::bit> bits(ewah.begin(), ewah.end());
+		std::vector<DB::bit> expectedBits{};
+		for (size_t i = 0; i < bitset.size(); i++)
+		{
+			expectedBits.push_back(bitset.get(i / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(i % DB::sNumOfBitsInByte)));
+		}
+
+		return ewah.size() == bitset.size()
+			&& isSame(ewah.to_dynamic_bitset(), bitset)
+			&& ewah.count() == bitset.count()
+			&& setBitIndices == getSetBitIndices(bitset)
+			&& bits == expectedBits;
+	}
+
+	// Appending in any way keeps the same bits as the bitset, and compressing the bitset gives the same.
+	void testAppend()
+	{
+		for (size_t i = 0; i < 50; i++)
+		{
+			DB::ewah_bitset ewah{};
+			DB::dynamic_bitset bitset{};
+			appendRandomly(ewah, bitset, sRandom() % 100);
+			DB_CHECK(isSame(ewah, bitset));
+			DB_CHECK(isSame(DB::ewah_bitset(bitset), bitset));
+
+			ewah.clear();
+			DB_CHECK(ewah.empty() && ewah.begin() == ewah.end() && isSame(ewah, {}));
+		}
+	}
+
+	// The operators match those of dynamic_bitset, keeping the size of the left hand side, for any mix of
+	// fills and literals on either side.
+	void testSetAlgebra()
+	{
+		for (size_t i = 0; i < 200; i++)
+		{
+			DB::ewah_bitset lhs{};
+			DB::ewah_bitset rhs{};
+			DB::dynamic_bitset lhsBitset{};
+			DB::dynamic_bitset rhsBitset{};
+			appendRandomly(lhs, lhsBitset, sRandom() % 60);
+			appendRandomly(rhs, rhsBitset, sRandom() % 60);
+
+			DB_CHECK(isSame(lhs & rhs, lhsBitset & rhsBitset));
+			DB_CHECK(isSame(lhs | rhs, lhsBitset | rhsBitset));
+			DB_CHECK(isSame(lhs ^ rhs, lhsBitset ^ rhsBitset));
+
+			DB::ewah_bitset result = lhs;
+			result |= rhs;
+			result ^= rhs;
+			result &= lhs;
+			DB_CHECK(isSame(result, andnot(lhsBitset, rhsBitset)));
+		}
+	}
+
+	// A run of more words than one marker can count continues in the next marker, and is still counted,
+	// skipped and combined without visiting its words. The bitsets are far too large to decompress.
+	void testRunsLongerThanAMarker()
+	{
+		const size_t numOfWords = DB::detail::sEwahMaxNumOfFillWords + 3;
+
+		DB::ewah_bitset ones{};
+		ones.push_back(true, numOfWords * sNumOfBitsInWord + 5);
+		DB_CHECK(ones.size() == numOfWords * sNumOfBitsInWord + 5 && ones.count() == ones.size());
+		DB_CHECK(ones.num_words() == 3);
+
+		// A literal between two long runs of zeros.
+		DB::ewah_bitset sparse{};
+		sparse.push_back(false, numOfWords * sNumOfBitsInWord);
+		sparse.write_bits(0b101, 3);
+		sparse.push_back(false, numOfWords * sNumOfBitsInWord);
+		sparse.push_back(true);
+
+		std::vector<size_t> setBitIndices{};
+		sparse.for_each_set_bit([&setBitIndices](size_t bitIndex) { setBitIndices.push_back(bitIndex); });
+		const size_t literalBitIndex = numOfWords * sNumOfBitsInWord;
+		DB_CHECK((setBitIndices == std::vector<size_t>{ literalBitIndex, literalBitIndex + 2, sparse.size() - 1 }));
+
+		DB_CHECK((sparse & ones).count() == 2 && (sparse & ones).size() == sparse.size());
+		DB_CHECK((ones & sparse).count() == 2 && (ones & sparse).size() == ones.size());
+		DB_CHECK((ones ^ sparse).count() == ones.size() - 2);
+		DB_CHECK((sparse | ones).count() == ones.size() + 1);
+	}
+}
+
+int main()
+{
+	testAppend();
+	testSetAlgebra();
+	testRunsLongerThanAMarker();
+	return DB::test::sNumOfFailures;
+}
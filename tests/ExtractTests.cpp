@@ -0,0 +1,112 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "Check.h"
+#include "DynamicBitset.h"
+
+namespace
+{
+	struct Record
+	{
+		std::uint32_t id;
+		std::uint16_t flags;
+		std::array<unsigned char, 5> tag;
+	};
+
+	constexpr std::uint64_t sValue = 0x0123456789ABCDEF;
+	constexpr std::uint32_t sSmallValue = 0xDEADBEEF;
+	constexpr Record sRecord{ 42, 0xF00D, { 1, 2, 3, 4, 5 } };
+
+	bool isSameRecord(const Record& a, const Record& b)
+	{
+		return a.id == b.id && a.flags == b.flags && a.tag == b.tag;
+	}
+
+	// Pushes a prefix of numOfPrefixBits bits and then a few values, so that they start at every offset
+	// within a block and the last one ends in the incomplete last block.
+	template<typename Bitset>
+	Bitset makeBitset(size_t numOfPrefixBits)
+	{
+		Bitset bitset{};
+		for (size_t i = 0; i < numOfPrefixBits; i++)
+		{
+			bitset.push_back(static_cast<DB::bit>(i % 3 == 0));
+		}
+		bitset.push_back(sValue);
+		bitset.push_back(sSmallValue);
+		bitset.push_back(sRecord);
+		bitset.push_back(sSmallValue);
+		return bitset;
+	}
+
+	// Extracting advances the iterator by the size of the type, whether or not it starts byte aligned.
+	template<typename Bitset>
+	void testExtractAdvancesIterator(size_t numOfPrefixBits)
+	{
+		Bitset bitset = makeBitset<Bitset>(numOfPrefixBits);
+
+		typename Bitset::iterator it = bitset.begin() + static_cast<std::ptrdiff_t>(numOfPrefixBits);
+		DB_CHECK(Bitset::template extract<std::uint64_t>(it) == sValue);
+		DB_CHECK(Bitset::template extract<std::uint32_t>(it) == sSmallValue);
+		DB_CHECK(isSameRecord(Bitset::template extract<Record>(it), sRecord));
+		DB_CHECK(Bitset::template extract<std::uint32_t>(it) == sSmallValue);
+		DB_CHECK(it == bitset.end());
+	}
+
+	// Extracting at a byte and bit index reads the same bytes as through an iterator.
+	template<typename Bitset>
+	void testExtractAtIndex(size_t numOfPrefixBits)
+	{
+		Bitset bitset = makeBitset<Bitset>(numOfPrefixBits);
+		const auto byteIndex = numOfPrefixBits / DB::sNumOfBitsInByte;
+		const auto bitIndex = static_cast<DB::bit_index>(numOfPrefixBits % DB::sNumOfBitsInByte);
+		DB_CHECK(bitset.template extract<std::uint64_t>(byteIndex, bitIndex) == sValue);
+
+		// The last value is (partly) in the incomplete last block for most prefixes.
+		const size_t lastBitIndex = bitset.size() - sizeof(sSmallValue) * DB::sNumOfBitsInByte;
+		DB_CHECK(bitset.template extract<std::uint32_t>(lastBitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(lastBitIndex % DB::sNumOfBitsInByte)) == sSmallValue);
+
+		std::array<char, sizeof(sValue) + sizeof(sSmallValue)> bytes{};
+		bitset.extract(bytes.data(), bytes.size(), byteIndex, bitIndex);
+		DB_CHECK(std::memcmp(bytes.data(), &sValue, sizeof(sValue)) == 0);
+		DB_CHECK(std::memcmp(bytes.data() + sizeof(sValue), &sSmallValue, sizeof(sSmallValue)) == 0);
+	}
+
+	// Extracting no bytes into no destination does nothing, also from an empty bitset without any blocks.
+	template<typename Bitset>
+	void testExtractNothing()
+	{
+		Bitset empty{};
+		empty.extract(nullptr, 0, 0, 0);
+		typename Bitset::iterator it = empty.begin();
+		Bitset::extract(nullptr, 0, it);
+		DB_CHECK(it == empty.end());
+
+		Bitset bitset = makeBitset<Bitset>(3);
+		it = bitset.begin() + 3;
+		Bitset::extract(nullptr, 0, it);
+		DB_CHECK(it == bitset.begin() + 3);
+	}
+
+	template<typename Bitset>
+	void testExtract()
+	{
+		testExtractNothing<Bitset>();
+
+		for (size_t numOfPrefixBits = 0; numOfPrefixBits <= 2 * DB::sNumOfBitsInType<std::uint64_t>; numOfPrefixBits++)
+		{
+			testExtractAdvancesIterator<Bitset>(numOfPrefixBits);
+			testExtractAtIndex<Bitset>(numOfPrefixBits);
+		}
+	}
+}
+
+int main()
+{
+	testExtract<DB::dynamic_bitset>();
+	testExtract<DB::basic_dynamic_bitset<unsigned char>>();
+	testExtract<DB::basic_dynamic_bitset<std::uint16_t>>();
+	testExtract<DB::basic_dynamic_bitset<std::uint32_t>>();
+	return DB::test::sNumOfFailures;
+}
@@ -0,0 +1,109 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "RankSelect.h"
+
+namespace
+{
+	// Checks rank1/rank0 at a stride and select1/select0 of every set and unset bit against a plain scan.
+	template<typename Bitset>
+	void checkAgainstScan(const DB::rank_select_bitset<Bitset>& bitset, const std::vector<bool>& bits)
+	{
+		std::vector<size_t> setBits{};
+		std::vector<size_t> unsetBits{};
+		for (size_t i = 0; i < bits.size(); i++)
+		{
+			if (i % 97 == 0)
+			{
+				DB_CHECK(bitset.rank1(i) == setBits.size());
+				DB_CHECK(bitset.rank0(i) == unsetBits.size());
+			}
+			(bits[i] ? setBits : unsetBits).push_back(i);
+		}
+		DB_CHECK(bitset.rank1(bits.size()) == setBits.size());
+		DB_CHECK(bitset.rank0(bits.size()) == unsetBits.size());
+
+		for (size_t i = 0; i < setBits.size(); i++)
+		{
+			DB_CHECK(bitset.select1(i) == setBits[i]);
+		}
+		for (size_t i = 0; i < unsetBits.size(); i++)
+		{
+			DB_CHECK(bitset.select0(i) == unsetBits[i]);
+		}
+	}
+
+	template<typename Bitset>
+	void testRandom(unsigned percentOfSetBits, size_t numOfBits)
+	{
+		std::mt19937 random(percentOfSetBits);
+		DB::rank_select_bitset<Bitset> bitset{};
+		std::vector<bool> bits{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			const bool value = random() % 100 < percentOfSetBits;
+			bitset.push_back(static_cast<DB::bit>(value));
+			bits.push_back(value);
+		}
+		checkAgainstScan(bitset, bits);
+
+		// Changing the bitset rebuilds the index on the next query.
+		for (size_t i = 0; i < 5000 && !bits.empty(); i++)
+		{
+			bitset.pop_back();
+			bits.pop_back();
+		}
+		for (size_t i = 0; i < 3000; i++)
+		{
+			const bool value = random() % 2;
+			bitset.push_back(static_cast<DB::bit>(value));
+			bits.push_back(value);
+		}
+		checkAgainstScan(bitset, bits);
+	}
+
+	// Sets (or unsets) only a few bits far apart, so that the select samples are many super blocks apart.
+	void testSparse(bool value)
+	{
+		constexpr size_t numOfBits = size_t{ 1 } << 24;
+		constexpr size_t stride = 1000003;
+
+		DB::dynamic_bitset bitset{};
+		bitset.resize(numOfBits);
+		std::vector<size_t> positions{};
+		for (size_t i = 12345; i < numOfBits; i += stride)
+		{
+			bitset.getBitRef(i / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(i % DB::sNumOfBitsInByte)) = true;
+			positions.push_back(i);
+		}
+		if (!value)
+		{
+			bitset = ~bitset;
+		}
+
+		const DB::rank_select_bitset<> sparse{ std::move(bitset) };
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			DB_CHECK((value ? sparse.select1(i) : sparse.select0(i)) == positions[i]);
+			DB_CHECK((value ? sparse.rank1(positions[i]) : sparse.rank0(positions[i])) == i);
+		}
+	}
+}
+
+int main()
+{
+	for (unsigned percentOfSetBits : { 0, 1, 50, 99, 100 })
+	{
+		for (size_t numOfBits : { 1, 2048, 4095, 100000, 300001 })
+		{
+			testRandom<DB::dynamic_bitset>(percentOfSetBits, numOfBits + 5000);
+		}
+	}
+	testRandom<DB::basic_dynamic_bitset<unsigned char>>(30, 100000);
+	testSparse(true);
+	testSparse(false);
+	return DB::test::sNumOfFailures;
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "DynamicBitset.h"
+#include "RoaringBitset.h"
+
+// The sets are checked against a dynamic_bitset in which the bit of every value is set. The values are
+// within the first few chunks, each of which is empty, sparse, dense or full.
+namespace
+{
+	using Value = DB::roaring_bitset::value_type;
+
+	constexpr size_t sChunkSize = DB::detail::sRoaringChunkSize;
+	constexpr size_t sMaxArraySize = DB::detail::sRoaringMaxArraySize;
+	constexpr size_t sNumOfChunks = 5;
+
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	// The number of bytes a set of a single array, bitmap or run chunk takes up, which tells them apart.
+	constexpr size_t getArraySize(size_t numOfValues)
+	{
+		return sizeof(DB::detail::RoaringChunk) + numOfValues * sizeof(std::uint16_t);
+	}
+
+	constexpr size_t sBitmapSize = sizeof(DB::detail::RoaringChunk) + DB::detail::sRoaringNumOfWordsInBitmap * sizeof(std::uint64_t);
+
+	constexpr size_t getRunsSize(size_t numOfRuns)
+	{
+		return sizeof(DB::detail::RoaringChunk) + numOfRuns * 2 * sizeof(std::uint16_t);
+	}
+
+	// Fills every chunk with a random number of values, mostly around the size at which arrays become bitmaps.
+	DB::dynamic_bitset makeRandomBitset()
+	{
+		DB::dynamic_bitset bitset{};
+		bitset.resize(sNumOfChunks * sChunkSize);
+
+		std::vector<size_t> lowBits(sChunkSize);
+		std::iota(lowBits.begin(), lowBits.end(), size_t{ 0 });
+
+		for (size_t chunkIndex = 0; chunkIndex < sNumOfChunks; chunkIndex++)
+		{
+			const size_t numsOfValues[] = { 0, 1, 2, sMaxArraySize - 1, sMaxArraySize, sMaxArraySize + 1, 30000, sChunkSize };
+			const size_t numOfValues = numsOfValues[sRandom() % std::size(numsOfValues)];
+
+			std::shuffle(lowBits.begin(), lowBits.end(), sRandom);
+			for (size_t i = 0; i < numOfValues; i++)
+			{
+				*(bitset.begin() + (chunkIndex * sChunkSize + lowBits[i])) = true;
+			}
+		}
+		return bitset;
+	}
+
+	std::vector<size_t> getValues(const DB::dynamic_bitset& bitset)
+	{
+		std::vector<size_t> values{};
+		bitset.for_each_set_bit([&values](size_t bitIndex) { values.push_back(bitIndex); });
+		return values;
+	}
+
+	std::vector<size_t> getValues(const DB::roaring_bitset& set)
+	{
+		std::vector<size_t> values{};
+		set.for_each_set_bit([&values](Value value) { values.push_back(value); });
+		return values;
+	}
+
+	bool isSame(const DB::roaring_bitset& set, const DB::dynamic_bitset& bitset)
+	{
+		const std::vector<size_t> values = getValues(bitset);
+		const DB::dynamic_bitset converted = set.to_dynamic_bitset();
+
+		return set.count() == values.size()
+			&& set.empty() == values.empty()
+			&& getValues(set) == values
+			&& getValues(converted) == values
+			&& converted.size() == (values.empty() ? 0 : values.back() + 1)
+			&& (values.empty() || set.max() == values.back());
+	}
+
+	// Converting from a bitset, adding and removing values, and run_optimize() all keep the same values as
+	// the bitset, which contains() agrees with for every value.
+	void testConversionsAndUpdates()
+	{
+		for (size_t i = 0; i < 10; i++)
+		{
+			DB::dynamic_bitset bitset = makeRandomBitset();
+			DB::roaring_bitset set(bitset);
+			DB_CHECK(isSame(set, bitset));
+
+			for (size_t j = 0; j < 20000; j++)
+			{
+				const Value value = static_cast<Value>(sRandom() % bitset.size());
+				const DB::bit isAdded = (sRandom() & 1) != 0;
+				if (isAdded)
+				{
+					set.add(value);
+				}
+				else
+				{
+					set.remove(value);
+				}
+				*(bitset.begin() + value) = isAdded;
+
+				if (j % 5000 == 0)
+				{
+					set.run_optimize();
+				}
+			}
+			DB_CHECK(isSame(set, bitset));
+
+			set.run_optimize();
+			DB_CHECK(isSame(set, bitset));
+			for (size_t value = 0; value < bitset.size(); value++)
+			{
+				DB_CHECK(set.contains(static_cast<Value>(value)) == static_cast<DB::bit>(*(bitset.begin() + value)));
+			}
+		}
+	}
+
+	// A chunk is an array up to 4096 values and a bitmap above that, whether it gets there by adding,
+	// removing or converting. Runs are used once optimized, and any change turns them back.
+	void testContainerThresholds()
+	{
+		DB::roaring_bitset set{};
+		for (Value value = 0; value < 2 * sMaxArraySize; value += 2)
+		{
+			set.add(value);
+		}
+		DB_CHECK(set.count() == sMaxArraySize && set.memory_usage() == getArraySize(sMaxArraySize));
+
+		set.add(1);
+		DB_CHECK(set.count() == sMaxArraySize + 1 && set.memory_usage() == sBitmapSize && set.contains(1));
+
+		set.remove(1);
+		set.remove(0);
+		DB_CHECK(set.count() == sMaxArraySize - 1 && set.memory_usage() == getArraySize(sMaxArraySize - 1) && !set.contains(0));
+
+		DB::dynamic_bitset bitset = set.to_dynamic_bitset();
+		DB_CHECK(DB::roaring_bitset(bitset).memory_usage() == getArraySize(sMaxArraySize - 1));
+		*(bitset.begin() + 1) = true;
+		*(bitset.begin() + 3) = true;
+		DB_CHECK(DB::roaring_bitset(bitset).memory_usage() == sBitmapSize);
+
+		// A range is a single run, as a bitmap or an array.
+		DB::roaring_bitset range{};
+		for (Value value = 100; value < 100 + 2 * sMaxArraySize; value++)
+		{
+			range.add(value);
+		}
+		range.run_optimize();
+		DB_CHECK(range.memory_usage() == getRunsSize(1) && range.count() == 2 * sMaxArraySize);
+		DB_CHECK(range.contains(100) && range.contains(99 + 2 * sMaxArraySize) && !range.contains(99) && range.max() == 99 + 2 * sMaxArraySize);
+
+		range.remove(200);
+		DB_CHECK(range.memory_usage() == sBitmapSize && range.count() == 2 * sMaxArraySize - 1 && !range.contains(200));
+		range.run_optimize();
+		DB_CHECK(range.memory_usage() == getRunsSize(2));
+		range.add(200);
+		DB_CHECK(range.memory_usage() == sBitmapSize && range.count() == 2 * sMaxArraySize);
+
+		DB::roaring_bitset small{};
+		for (Value value = 10; value < 20; value++)
+		{
+			small.add(value);
+		}
+		small.run_optimize();
+		DB_CHECK(small.memory_usage() == getRunsSize(1));
+		small.add(30);
+		DB_CHECK(small.memory_usage() == getArraySize(11) && small.contains(30) && small.contains(19));
+	}
+
+	// The operators match those of dynamic_bitset, whatever mix of arrays, bitmaps and runs the chunks are.
+	void testSetAlgebra()
+	{
+		for (size_t i = 0; i < 20; i++)
+		{
+			const DB::dynamic_bitset lhsBitset = makeRandomBitset();
+			const DB::dynamic_bitset rhsBitset = makeRandomBitset();
+			DB::roaring_bitset lhs(lhsBitset);
+			DB::roaring_bitset rhs(rhsBitset);
+			if (i % 2 == 0)
+			{
+				lhs.run_optimize();
+			}
+			if (i % 3 == 0)
+			{
+				rhs.run_optimize();
+			}
+
+			DB_CHECK(isSame(lhs & rhs, lhsBitset & rhsBitset));
+			DB_CHECK(isSame(lhs | rhs, lhsBitset | rhsBitset));
+			DB_CHECK(isSame(lhs & rhsBitset, lhsBitset & rhsBitset));
+
+			// A shorter bitset has no bits for the values past its end.
+			DB::dynamic_bitset shorterBitset = rhsBitset;
+			shorterBitset.resize(sChunkSize + 100);
+			DB_CHECK(isSame(lhs & shorterBitset, lhsBitset & shorterBitset));
+
+			DB::roaring_bitset result = lhs;
+			result |= rhs;
+			result &= lhs;
+			result &= rhsBitset;
+			DB_CHECK(isSame(result, lhsBitset & rhsBitset));
+		}
+	}
+
+	// Values in the last chunk, up to the largest one, are stored and found like any others.
+	void testLargestValues()
+	{
+		const Value largestValue = ~Value{};
+
+		DB::roaring_bitset set{};
+		set.add(largestValue);
+		set.add(largestValue - 1);
+		set.add(5);
+		DB_CHECK(set.count() == 3 && set.max() == largestValue && set.contains(largestValue) && !set.contains(largestValue - 2));
+		DB_CHECK((getValues(set) == std::vector<size_t>{ 5, largestValue - 1, largestValue }));
+
+		set.remove(largestValue);
+		DB_CHECK(set.max() == largestValue - 1 && set.count() == 2);
+	}
+}
+
+int main()
+{
+	testConversionsAndUpdates();
+	testContainerThresholds();
+	testSetAlgebra();
+	testLargestValues();
+	return DB::test::sNumOfFailures;
+}
@@ -0,0 +1,179 @@
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Serialization.h"
+#include "StaticCapacityBitset.h"
+
+namespace
+{
+	template<typename Bitset>
+	Bitset makeBitset(size_t numOfBits)
+	{
+		std::mt19937_64 random(numOfBits);
+		Bitset bitset{};
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			bitset.push_back(static_cast<DB::bit>(random() & 1));
+		}
+		return bitset;
+	}
+
+	template<typename A, typename B>
+	bool haveSameBits(const A& a, const B& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			const auto byteIndex = i / DB::sNumOfBitsInByte;
+			const auto bitIndex = static_cast<DB::bit_index>(i % DB::sNumOfBitsInByte);
+			if (a.get(byteIndex, bitIndex) != b.get(byteIndex, bitIndex))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string serialize(const DB::dynamic_bitset& bitset, bool withChecksum = true)
+	{
+		std::ostringstream stream;
+		DB::write(stream, bitset, withChecksum);
+		return stream.str();
+	}
+
+	// Reads the bytes into a bitset with the given blocks, and returns whether that threw a serialization_error.
+	template<typename Block = std::uint64_t>
+	bool failsToRead(const std::string& bytes)
+	{
+		DB::basic_dynamic_bitset<Block> bitset{};
+		bitset.push_back(DB::bit(true));
+		std::istringstream stream(bytes);
+		try
+		{
+			DB::read(stream, bitset);
+		}
+		catch (const DB::serialization_error&)
+		{
+			// A failed read leaves the bitset empty rather than partly read.
+			return bitset.empty();
+		}
+		return false;
+	}
+
+	template<typename Type>
+	void patch(std::string& bytes, size_t offset, Type value)
+	{
+		DB::detail::storeLittleEndian(reinterpret_cast<unsigned char*>(bytes.data()) + offset, value);
+	}
+
+	// Round trips through the same and through different block layouts, including payloads of several chunks.
+	void testRoundTrip()
+	{
+		for (size_t numOfBits : { 0, 1, 63, 64, 65, 12345, 10000019 })
+		{
+			const DB::dynamic_bitset bitset = makeBitset<DB::dynamic_bitset>(numOfBits);
+			for (bool withChecksum : { true, false })
+			{
+				const std::string bytes = serialize(bitset, withChecksum);
+				DB_CHECK(bytes.size() == DB::detail::sSerializedHeaderSize + bitset.num_words() * sizeof(std::uint64_t));
+
+				std::istringstream stream(bytes);
+				DB::dynamic_bitset sameBlocks{};
+				DB::read(stream, sameBlocks);
+				DB_CHECK(haveSameBits(sameBlocks, bitset));
+
+				std::istringstream otherStream(bytes);
+				DB::basic_dynamic_bitset<std::uint16_t> otherBlocks{};
+				DB::read(otherStream, otherBlocks);
+				DB_CHECK(haveSameBits(otherBlocks, bitset));
+
+				std::vector<std::uint64_t> aligned((bytes.size() + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+				std::memcpy(aligned.data(), bytes.data(), bytes.size());
+				DB_CHECK(haveSameBits(DB::load_view(std::as_bytes(std::span(aligned)).first(bytes.size())), bitset));
+			}
+		}
+	}
+
+	// Invalid or truncated input throws a serialization_error rather than anything else.
+	void testInvalidInput()
+	{
+		const std::string bytes = serialize(makeBitset<DB::dynamic_bitset>(100));
+		DB_CHECK(!failsToRead(bytes));
+
+		DB_CHECK(failsToRead(bytes.substr(0, 16)));
+		DB_CHECK(failsToRead(bytes.substr(0, bytes.size() - 1)));
+		DB_CHECK(failsToRead<unsigned char>(bytes.substr(0, bytes.size() - 1)));
+
+		std::string corrupted = bytes;
+		corrupted.back() ^= 1;
+		DB_CHECK(failsToRead(corrupted));
+		DB_CHECK(failsToRead<unsigned char>(corrupted));
+
+		// A huge number of bits fails on the short read instead of allocating for all of them.
+		for (std::uint64_t numOfBits : { std::uint64_t{ 1 } << 45, ~std::uint64_t{} })
+		{
+			std::string huge = bytes;
+			patch(huge, 16, numOfBits);
+			DB_CHECK(failsToRead(huge));
+			DB_CHECK(failsToRead<unsigned char>(huge));
+		}
+
+		std::string unknownVersion = bytes;
+		patch(unknownVersion, 4, std::uint16_t{ 2 });
+		DB_CHECK(failsToRead(unknownVersion));
+
+		std::string unknownFlag = bytes;
+		patch(unknownFlag, 6, std::uint16_t{ 3 });
+		DB_CHECK(failsToRead(unknownFlag));
+
+		std::string checksumWithoutFlag = serialize(makeBitset<DB::dynamic_bitset>(100), false);
+		patch(checksumWithoutFlag, 24, std::uint32_t{ 1 });
+		DB_CHECK(failsToRead(checksumWithoutFlag));
+
+		for (size_t offset : { 10, 15, 28, 31 })
+		{
+			std::string reserved = bytes;
+			reserved[offset] = 1;
+			DB_CHECK(failsToRead(reserved));
+		}
+	}
+
+	// A bitset that can't hold what is read is left empty, whether the blocks are read straight into it or
+	// converted from another layout.
+	template<typename Bitset>
+	void testReadPastCapacity()
+	{
+		std::istringstream stream(serialize(makeBitset<DB::dynamic_bitset>(1000)));
+		Bitset bitset{};
+		bool threw = false;
+		try
+		{
+			DB::read(stream, bitset);
+		}
+		catch (const std::bad_alloc&)
+		{
+			threw = true;
+		}
+		DB_CHECK(threw);
+		DB_CHECK(bitset.empty());
+	}
+}
+
+int main()
+{
+	testRoundTrip();
+	testInvalidInput();
+	testReadPastCapacity<DB::static_capacity_bitset<512>>();
+	testReadPastCapacity<DB::static_capacity_bitset<512, std::uint16_t>>();
+	return DB::test::sNumOfFailures;
+}
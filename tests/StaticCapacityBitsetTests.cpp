@@ -0,0 +1,75 @@
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "Check.h"
+#include "StaticCapacityBitset.h"
+
+namespace
+{
+	template<typename Function>
+	bool throwsBadAlloc(Function&& function)
+	{
+		try
+		{
+			function();
+		}
+		catch (const std::bad_alloc&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	// Filling the bitset up to its capacity works, anything past it throws and leaves the bitset unchanged.
+	template<size_t NumOfBits, typename Block>
+	void testCapacity()
+	{
+		using Bitset = DB::static_capacity_bitset<NumOfBits, Block>;
+		constexpr size_t capacity = DB::detail::getNumOfBlocksNeeded<Block>(NumOfBits) * DB::sNumOfBitsInType<Block>;
+
+		Bitset bitset{};
+		for (size_t i = 0; i < capacity; i++)
+		{
+			bitset.push_back(static_cast<DB::bit>(i % 2));
+		}
+		DB_CHECK(bitset.size() == capacity);
+
+		DB_CHECK(throwsBadAlloc([&] { bitset.push_back(DB::bit(true)); }));
+		DB_CHECK(throwsBadAlloc([&] { bitset.push_back(std::uint8_t{ 0xFF }); }));
+		DB_CHECK(throwsBadAlloc([&] { bitset.write_bits(1, 1); }));
+		DB_CHECK(throwsBadAlloc([&] { bitset.resize(capacity + 1); }));
+		DB_CHECK(throwsBadAlloc([&] { bitset.reserve(capacity + 1); }));
+
+		DB_CHECK(bitset.size() == capacity);
+		DB_CHECK(bitset.count() == capacity / 2);
+
+		// A value that only partly fits doesn't change the bitset either.
+		bitset.resize(capacity - 4);
+		DB_CHECK(throwsBadAlloc([&] { bitset.push_back(std::uint8_t{ 0xFF }); }));
+		DB_CHECK(bitset.size() == capacity - 4);
+		DB_CHECK(bitset.count() == (capacity - 4) / 2);
+
+		// Neither does growing with set bits from a size that isn't a whole number of blocks, which must not
+		// leave set bits past the end.
+		DB_CHECK(throwsBadAlloc([&] { bitset.resize(capacity + 1, true); }));
+		DB_CHECK(bitset.size() == capacity - 4);
+		bitset.write_bits(0, 4);
+		DB_CHECK(bitset.count() == (capacity - 4) / 2);
+
+		Bitset partlyFilled{};
+		partlyFilled.resize(NumOfBits > 8 ? NumOfBits - 8 : 1);
+		DB_CHECK(throwsBadAlloc([&] { partlyFilled.resize(capacity + 1, true); }));
+		partlyFilled.resize(capacity);
+		DB_CHECK(partlyFilled.count() == 0);
+	}
+}
+
+int main()
+{
+	testCapacity<64, std::uint64_t>();
+	testCapacity<100, std::uint64_t>();
+	testCapacity<20, std::uint8_t>();
+	testCapacity<1000, std::uint16_t>();
+	return DB::test::sNumOfFailures;
+}
@@ -0,0 +1,146 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "DynamicBitset.h"
+#include "SummaryBitset.h"
+
+// The summary bitsets are checked against a plain bitset with the same changes, whose find functions
+// scan every block.
+namespace
+{
+	std::mt19937_64 sRandom{ 0x0123456789ABCDEF };
+
+	template<typename Bitset>
+	DB::bit getBit(const Bitset& bitset, size_t bitIndex)
+	{
+		return bitset.get(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte));
+	}
+
+	// Compares finding from every set bit, and from random positions, most of which are in empty words.
+	template<typename Bitset>
+	bool isSame(const DB::summary_bitset<Bitset>& summary, const Bitset& bitset)
+	{
+		if (summary.size() != bitset.size() || summary.count() != bitset.count() || summary.find_first() != bitset.find_first())
+		{
+			return false;
+		}
+
+		std::vector<size_t> setBitIndices{};
+		summary.for_each_set_bit([&setBitIndices](size_t bitIndex) { setBitIndices.push_back(bitIndex); });
+
+		std::vector<size_t> expectedSetBitIndices{};
+		for (size_t i = bitset.find_first(); i != Bitset::npos; i = bitset.find_next(i))
+		{
+			expectedSetBitIndices.push_back(i);
+		}
+
+		if (setBitIndices != expectedSetBitIndices)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < 1000 && !bitset.empty(); i++)
+		{
+			const size_t bitIndex = sRandom() % bitset.size();
+			if (summary.find_next(bitIndex) != bitset.find_next(bitIndex) || summary.test(bitIndex) != getBit(bitset, bitIndex))
+			{
+				return false;
+			}
+		}
+		return summary.find_next(DB::summary_bitset<Bitset>::npos) == DB::summary_bitset<Bitset>::npos;
+	}
+
+	// Sparse random changes to a bitset large enough for three levels of summaries, with appends and
+	// removals at the end that add and drop whole words and levels.
+	template<typename Bitset>
+	void testChanges()
+	{
+		// More than 64 * 64 words, so that there are three levels.
+		const size_t numOfBits = 64 * 64 * 64 + 1000;
+
+		Bitset bitset{};
+		bitset.resize(numOfBits);
+		DB::summary_bitset<Bitset> summary(bitset);
+		DB_CHECK(isSame(summary, bitset) && summary.find_first() == DB::summary_bitset<Bitset>::npos);
+
+		for (size_t round = 0; round < 20; round++)
+		{
+			for (size_t i = 0; i < 50; i++)
+			{
+				const size_t bitIndex = sRandom() % bitset.size();
+				const DB::bit value = sRandom() % 3 != 0;
+				switch (sRandom() % 3)
+				{
+				case 0:
+					summary.set(bitIndex, value);
+					break;
+				case 1:
+					summary[bitIndex] = value;
+					break;
+				default:
+					if (value)
+					{
+						summary.set(bitIndex);
+					}
+					else
+					{
+						summary.reset(bitIndex);
+					}
+					break;
+				}
+				bitset.getBitRef(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte)) = value;
+			}
+
+			// Clears the set bits of a random word, so that it drops out of the summaries.
+			const size_t firstBitIndex = sRandom() % bitset.size() / 64 * 64;
+			for (size_t bitIndex = firstBitIndex; bitIndex < firstBitIndex + 64 && bitIndex < bitset.size(); bitIndex++)
+			{
+				summary.reset(bitIndex);
+				bitset.getBitRef(bitIndex / DB::sNumOfBitsInByte, static_cast<DB::bit_index>(bitIndex % DB::sNumOfBitsInByte)) = false;
+			}
+			DB_CHECK(isSame(summary, bitset));
+
+			const size_t numOfBitsToPop = sRandom() % 300;
+			for (size_t i = 0; i < numOfBitsToPop && !bitset.empty(); i++)
+			{
+				summary.pop_back();
+				bitset.pop_back();
+			}
+			DB_CHECK(isSame(summary, bitset));
+
+			const std::uint64_t value = sRandom();
+			const unsigned numOfBits = static_cast<unsigned>(sRandom() % 65);
+			const std::uint32_t smallValue = static_cast<std::uint32_t>(sRandom());
+			summary.write_bits(value, numOfBits);
+			summary.push_back(smallValue);
+			summary.push_back(DB::bit{ true });
+			bitset.write_bits(value, numOfBits);
+			bitset.push_back(smallValue);
+			bitset.push_back(DB::bit{ true });
+			DB_CHECK(isSame(summary, bitset));
+		}
+
+		// Growing from nothing a bit at a time adds the levels one by one.
+		summary.clear();
+		bitset.clear();
+		DB_CHECK(isSame(summary, bitset) && summary.empty());
+		for (size_t i = 0; i < numOfBits; i++)
+		{
+			const DB::bit value = sRandom() % 1000 == 0;
+			summary.push_back(value);
+			bitset.push_back(value);
+		}
+		DB_CHECK(isSame(summary, bitset));
+	}
+}
+
+int main()
+{
+	testChanges<DB::dynamic_bitset>();
+	testChanges<DB::basic_dynamic_bitset<std::uint8_t>>();
+	testChanges<DB::basic_dynamic_bitset<std::uint32_t>>();
+	return DB::test::sNumOfFailures;
+}